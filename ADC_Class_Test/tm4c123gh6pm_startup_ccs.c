@@ -23,6 +23,8 @@
 //*****************************************************************************
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_types.h"
 
 //*****************************************************************************
 //
@@ -42,6 +44,14 @@ static void IntDefaultHandler(void);
 //*****************************************************************************
 extern void _c_int00(void);
 
+//*****************************************************************************
+//
+// External declaration for the fault handler of the application (see
+// System.cpp). It gets the registers stacked on exception entry.
+//
+//*****************************************************************************
+extern void SystemFaultHandler(uint32_t *frame);
+
 //*****************************************************************************
 //
 // Linker variable that marks the top of the stack.
@@ -71,9 +81,9 @@ void (* const g_pfnVectors[])(void) =
     ResetISR,                               // The reset handler
     NmiSR,                                  // The NMI handler
     FaultISR,                               // The hard fault handler
-    IntDefaultHandler,                      // The MPU fault handler
-    IntDefaultHandler,                      // The bus fault handler
-    IntDefaultHandler,                      // The usage fault handler
+    FaultISR,                               // The MPU fault handler
+    FaultISR,                               // The bus fault handler
+    FaultISR,                               // The usage fault handler
     0,                                      // Reserved
     0,                                      // Reserved
     0,                                      // Reserved
@@ -237,6 +247,15 @@ void (* const g_pfnVectors[])(void) =
 void
 ResetISR(void)
 {
+    //
+    // Start the DWT cycle counter from 0 to measure the boot time (see
+    // System::init): set TRCENA in DEMCR, clear CYCCNT and set CYCCNTENA in
+    // the DWT control register.
+    //
+    HWREG(0xE000EDFC) |= 0x01000000;
+    HWREG(0xE0001004) = 0;
+    HWREG(0xE0001000) |= 0x00000001;
+
     //
     // Jump to the CCS C initialization routine.  This will enable the
     // floating-point unit as well, so that does not need to be done here.
@@ -266,19 +285,21 @@ NmiSR(void)
 //*****************************************************************************
 //
 // This is the code that gets called when the processor receives a fault
-// interrupt.  This simply enters an infinite loop, preserving the system state
-// for examination by a debugger.
+// interrupt (hard, MPU, bus or usage fault).  It passes the registers stacked
+// on exception entry to the application, which switches the outputs off and
+// records the fault (see System::error).  Bit 2 of the EXC_RETURN value in lr
+// tells whether they have been stacked on the main or the process stack.
 //
 //*****************************************************************************
 static void
 FaultISR(void)
 {
-    //
-    // Enter an infinite loop.
-    //
-    while(1)
-    {
-    }
+    __asm("    tst     lr, #4\n"
+          "    ite     eq\n"
+          "    mrseq   r0, msp\n"
+          "    mrsne   r0, psp\n"
+          "    .global SystemFaultHandler\n"
+          "    b.w     SystemFaultHandler");
 }
 
 //*****************************************************************************
@@ -77,6 +77,9 @@ int main(void)
         // Otherwise read its data and send it to the computer.
 	    while (sensorEnable.read())
 	    {
+	        // Start of this sample period.
+	        Deadline nextSample(10000);
+
 	        // Read all data
 	        angleRate = sensor.getAngleRate();
 	        hor       = sensor.getAccelHor();
@@ -90,8 +93,8 @@ int main(void)
 	        // Send them to the Arduino plotter
 	        system.sendDebugVals();
 
-	        // Reduce update frequency to around 100Hz.
-	        system.delayUS(10000);
+	        // Update frequency of 100Hz, independent of the time needed above.
+	        nextSample.wait();
 	    }
 
 	    // Power down sensor
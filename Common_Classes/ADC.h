@@ -23,6 +23,8 @@ class ADC
 {
 public:
     ADC();
+    // Stays virtual: the precompiled library expects a vtable pointer in
+    // front of spaceForLib.
     virtual ~ADC();
     void init(System *sys, uint32_t base, uint32_t sampleSeq, uint32_t analogInput);
     void setHWAveraging(uint32_t averaging);
@@ -0,0 +1,285 @@
+/*
+ * BlackBox.cpp
+ *
+ *    Author:
+ *     Email:
+ *
+ * Crash-persistent flight recorder (see BlackBox.h).
+ */
+
+#include "BlackBox.h"
+
+/*
+ * stddef.h:                offsetof for the checksum.
+ * string.h:                memset.
+ * driverlib/sysctl.h:      Reset cause of the uC.
+ * System.h:                Debug UART for BlackBox::dump.
+ * TelemetryText.h:         Renders the lines of BlackBox::dump.
+ */
+#include <stddef.h>
+#include <string.h>
+#include "driverlib/sysctl.h"
+#include "System.h"
+#include "TelemetryText.h"
+
+
+/*
+ * The startup code neither zeroes nor initializes the .noinit section (see
+ * tm4c123gh6pm.cmd), therefore the content survives a reset.
+ */
+#ifdef __TI_ARM__
+#pragma DATA_SECTION(".noinit")
+#pragma NOINIT
+BlackBoxData BlackBox::bbData;
+#else
+BlackBoxData BlackBox::bbData __attribute__((section(".noinit")));
+#endif
+
+bool BlackBox::bbHadContent = false;
+
+
+void BlackBox::init()
+{
+    /*
+     * Check the content left by the previous boot. If it is invalid (f.ex.
+     * after power-up) the black box is cleared. Then the boot is counted and
+     * recorded together with the reset cause. Called by System::init.
+     */
+
+    if ((bbData.magic == bbMagic) && (bbData.checksum == checksum()))
+    {
+        bbHadContent = true;
+    }
+    else
+    {
+        memset(&bbData, 0, sizeof(bbData));
+        bbData.magic = bbMagic;
+        bbHadContent = false;
+    }
+
+    bbData.bootCount++;
+    bbData.resetCause = SysCtlResetCauseGet();
+    SysCtlResetCauseClear(bbData.resetCause);
+    bbData.checksum = checksum();
+
+    event(BBoxBoot, bbData.resetCause);
+}
+
+void BlackBox::event(BlackBoxEvent code, int16_t data0, int16_t data1)
+{
+    /*
+     * Record an event. Like BlackBox::record it must only be called from the
+     * control ISR (or before interrupts are enabled).
+     *
+     * code:  What happened.
+     * data:  Optional values, see BlackBoxEvent.
+     */
+
+    BlackBoxEntry &entry = bbData.entries[bbData.head & (BLACKBOX_ENTRIES - 1)];
+    entry.timestamp = TimeBase::getUS();
+    entry.type = BBoxEvent;
+    entry.boot = bbData.bootCount;
+    entry.code = code;
+    entry.data[0] = data0;
+    entry.data[1] = data1;
+    entry.data[2] = 0;
+    entry.data[3] = 0;
+    entry.seq = bbData.head;
+    bbData.head++;
+}
+
+void BlackBox::recordFault(const FaultRecord &fault)
+{
+    /*
+     * Store the fault record in the header and record the error as last
+     * entry. Called by System::error with interrupts disabled, the ring can
+     * therefore not be corrupted by the control ISR.
+     *
+     * fault: Everything known about the error.
+     */
+
+    bbData.fault = fault;
+    bbData.errorValid = true;
+    bbData.checksum = checksum();
+
+    BlackBoxEntry &entry = bbData.entries[bbData.head & (BLACKBOX_ENTRIES - 1)];
+    entry.timestamp = fault.timestamp;
+    entry.type = BBoxError;
+    entry.boot = bbData.bootCount;
+    entry.code = fault.errorCode;
+    entry.data[0] = fault.values[0];
+    entry.data[1] = fault.values[1];
+    entry.data[2] = fault.values[2];
+    entry.data[3] = 0;
+    entry.seq = bbData.head;
+    bbData.head++;
+}
+
+uint32_t BlackBox::getRestarts()
+{
+    /*
+     * Returns the number of consecutive restarts after recoverable errors.
+     */
+
+    return bbData.restarts;
+}
+
+void BlackBox::countRestart()
+{
+    /*
+     * Count a restart after a recoverable error (see System::error). Called
+     * with interrupts disabled right before the reset.
+     */
+
+    bbData.restarts++;
+    bbData.checksum = checksum();
+}
+
+void BlackBox::clearRestarts()
+{
+    /*
+     * Reset the number of consecutive restarts once the application runs
+     * properly again (f.ex. after CFG_SYS_STABLE_TIME of control cycles).
+     */
+
+    if (bbData.restarts)
+    {
+        bbData.restarts = 0;
+        bbData.checksum = checksum();
+    }
+}
+
+bool BlackBox::hasContent()
+{
+    /*
+     * Returns true if valid content of a previous boot has been found by
+     * BlackBox::init.
+     */
+
+    return bbHadContent;
+}
+
+void BlackBox::dump(System *sys)
+{
+    /*
+     * Send the content of the black box via the debug UART. Afterwards the
+     * error is cleared; the entries are kept and continue to be overwritten.
+     * Transmission format (tab separated):
+     *   BBOX\tBoot\t<boot count>\tReset\t<reset cause>\tRestarts\t<count>
+     *       \tError\t<code or -1>\tTime\t<us since reset>\tOrigins\t<3 pointers>
+     *       \tValues\t<3 values>\tStacked\t<r0-r3, r12, lr, pc, xPSR>
+     *       \tStatus\t<CFSR, HFSR, MMFAR, BFAR>
+     *   BBOX\tIndex\tBoot\tTime_[us]\tType\tCode\tData0\tData1\tData2\tData3
+     *   (one line per entry, oldest first)
+     * Everything after the error code belongs to the fault record (see
+     * FaultRecord) and is hexadecimal, like the reset cause
+     * (SYSCTL_CAUSE_...). Times are relative to the newest entry. Type is a
+     * BlackBoxType, Code a BlackBoxEvent, ErrorCodes value or cycle number.
+     * Note: Periodic debug values are paused meanwhile so that the lines do
+     *       not get mixed up. Do not call it from an ISR. Only sent with the
+     *       DebugText format (see System::getDebugFormat); the error is kept
+     *       for the next dump otherwise.
+     *
+     * sys: Pointer to the system object with the debug UART.
+     */
+
+    if (sys->getDebugFormat() != DebugText)
+    {
+        return;
+    }
+
+    // Large buffer, therefore not on the stack.
+    static TelemetryText text;
+
+    bool debugging = sys->getDebugging();
+    sys->setDebugging(false);
+
+    text.begin();
+    text.putString("BBOX\tBoot\t");
+    text.putInt(bbData.bootCount);
+    text.putString("\tReset\t");
+    text.putHex(bbData.resetCause);
+    text.putString("\tRestarts\t");
+    text.putInt(bbData.restarts);
+    text.putString("\tError\t");
+    text.putInt(bbData.errorValid ? (int32_t) bbData.fault.errorCode : -1);
+
+    // Fault record: label and number of words of each part.
+    const FaultRecord &fault = bbData.fault;
+    const char *labels[] = {"\tTime", "\tOrigins", "\tValues", "\tStacked",
+                            "\tStatus"};
+    const uint32_t *parts[] = {&fault.timestamp, fault.origins, fault.values,
+                               fault.stacked, fault.faultStatus};
+    const uint_fast8_t counts[] = {1, 3, 3, 8, 4};
+    for (uint_fast8_t i = 0; i < 5; i++)
+    {
+        text.putString(labels[i]);
+        for (uint_fast8_t j = 0; j < counts[i]; j++)
+        {
+            text.putChar('\t');
+            text.putHex(parts[i][j]);
+        }
+    }
+    text.endLine();
+    sys->queueDebugTx(text.getData(), text.getLength(), true);
+
+    const char header[] = "BBOX\tIndex\tBoot\tTime_[us]\tType\tCode\tData0"
+                          "\tData1\tData2\tData3\r\n";
+    sys->queueDebugTx(header, sizeof(header) - 1, true);
+
+    // The ring is not modified by the control ISR yet, as it is only
+    // started after the dump.
+    uint32_t head = bbData.head;
+    uint32_t newest = bbData.entries[(head - 1) & (BLACKBOX_ENTRIES - 1)].timestamp;
+    for (uint32_t i = 0; i < BLACKBOX_ENTRIES; i++)
+    {
+        uint32_t seq = head - BLACKBOX_ENTRIES + i;
+        const BlackBoxEntry &entry = bbData.entries[seq & (BLACKBOX_ENTRIES - 1)];
+        if (entry.seq != seq)
+        {
+            // Never written or torn by the reset.
+            continue;
+        }
+
+        text.begin();
+        text.putString("BBOX\t");
+        text.putInt(i - BLACKBOX_ENTRIES);
+        text.putChar('\t');
+        text.putInt(entry.boot);
+        text.putChar('\t');
+        text.putInt((int32_t) (entry.timestamp - newest));
+        text.putChar('\t');
+        text.putInt(entry.type);
+        text.putChar('\t');
+        text.putInt(entry.code);
+        for (uint_fast8_t j = 0; j < 4; j++)
+        {
+            text.putChar('\t');
+            text.putInt(entry.data[j]);
+        }
+        text.endLine();
+        sys->queueDebugTx(text.getData(), text.getLength(), true);
+    }
+
+    bbData.errorValid = false;
+    bbData.checksum = checksum();
+
+    sys->setDebugging(debugging);
+}
+
+uint32_t BlackBox::checksum()
+{
+    /*
+     * Returns a checksum of the header (everything before the checksum
+     * itself). Rotate and xor is enough to detect the random RAM content
+     * after power-up.
+     */
+
+    const uint32_t *words = &bbData.magic;
+    uint32_t sum = ~bbMagic;
+    for (uint32_t i = 0; i < offsetof(BlackBoxData, checksum) / 4; i++)
+    {
+        sum = ((sum << 5) | (sum >> 27)) ^ words[i];
+    }
+    return sum;
+}
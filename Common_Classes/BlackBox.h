@@ -0,0 +1,146 @@
+/*
+ * BlackBox.h
+ *
+ *    Author:
+ *     Email:
+ *
+ * Crash-persistent flight recorder. A ring of the most recent control
+ * records and events plus the last System::error call are kept in the
+ * .noinit RAM section (see tm4c123gh6pm.cmd), which is not initialized by the
+ * startup code. Therefore the content survives a watchdog, software or reset
+ * pin reset (but not a power cycle) and can be sent after the next boot
+ * (BlackBox::dump).
+ * A magic number and a checksum of the header detect invalid content (f.ex.
+ * after power-up). Each entry contains its sequence number, which is written
+ * last; entries whose number does not match their position are skipped.
+ * It also counts the restarts after recoverable errors (see System::error).
+ * Writing an entry costs a few stores, so it can stay enabled in production.
+ * Note: There is only one black box, therefore all methods are static.
+ *       Entries must only be written from one context (the control ISR, or
+ *       inside a critical section masking it) and by System::error. The boot
+ *       event is written before the interrupts are enabled.
+ */
+
+#ifndef BLACKBOX_H_
+#define BLACKBOX_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * ErrorCodes.h:            Enum with error codes for the error method.
+ * TimeBase.h:              Timestamps of the entries.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "ErrorCodes.h"
+#include "TimeBase.h"
+
+
+class System;
+
+
+// Entry types
+enum BlackBoxType {BBoxControl,     // One control cycle (see Segway::update)
+                   BBoxEvent,       // One of BlackBoxEvent
+                   BBoxError};      // System::error
+
+// Event codes
+enum BlackBoxEvent {BBoxBoot,           // data[0]: reset cause (low 16 bits)
+                    BBoxStandbyEnter,
+                    BBoxStandbyLeave,
+                    BBoxSleep,          // Deep-sleep, see Segway::deepSleep
+                    BBoxWake};          // data[0]: 1 if woken by the foot switch
+
+struct BlackBoxEntry
+{
+    uint32_t seq;           // Sequence number, written last
+    uint32_t timestamp;     // Microseconds since the reset (lowest 32 bits)
+    uint8_t type;           // BlackBoxType
+    uint8_t boot;           // Lowest byte of the boot counter
+    uint16_t code;          // Event or error code, cycle number for records
+    int16_t data[4];        // Depends on the type
+};
+
+// Number of entries (power of 2)
+#define BLACKBOX_ENTRIES    64
+
+struct FaultRecord
+{
+    /*
+     * Everything known about an error (see System::error). The CPU registers
+     * are only available for CPU faults (CPUFault), otherwise they are 0.
+     */
+    uint32_t errorCode;         // ErrorCodes
+    uint32_t timestamp;         // Microseconds since the reset (lowest 32 bits)
+    uint32_t origins[3];        // Pointers passed to System::error
+    uint32_t values[3];         // 32 bits at these pointers
+    uint32_t stacked[8];        // r0-r3, r12, lr, pc, xPSR of the faulting code
+    uint32_t faultStatus[4];    // CFSR, HFSR, MMFAR, BFAR
+};
+
+struct BlackBoxData
+{
+    // Header, protected by the checksum (which excludes head).
+    uint32_t magic;
+    uint32_t bootCount;
+    uint32_t resetCause;
+    uint32_t restarts;          // Consecutive restarts after errors
+    uint32_t errorValid;
+    FaultRecord fault;
+    uint32_t checksum;
+
+    // Ring
+    uint32_t head;
+    BlackBoxEntry entries[BLACKBOX_ENTRIES];
+};
+
+
+class BlackBox
+{
+public:
+    static void init();
+    static void event(BlackBoxEvent code, int16_t data0 = 0,
+                      int16_t data1 = 0);
+    static void recordFault(const FaultRecord &fault);
+    static uint32_t getRestarts();
+    static void countRestart();
+    static void clearRestarts();
+    static bool hasContent();
+    static void dump(System *sys);
+
+    static inline void record(uint16_t code, int16_t data0, int16_t data1,
+                              int16_t data2, int16_t data3)
+    {
+        /*
+         * Write one control record (type BBoxControl). Must only be called
+         * from the control ISR.
+         *
+         * code:  Number of the control cycle (lowest 16 bits).
+         * data:  Values of the cycle, see Segway::update.
+         */
+
+        BlackBoxEntry &entry = bbData.entries[bbData.head & (BLACKBOX_ENTRIES - 1)];
+        entry.timestamp = TimeBase::getUS();
+        entry.type = BBoxControl;
+        entry.boot = bbData.bootCount;
+        entry.code = code;
+        entry.data[0] = data0;
+        entry.data[1] = data1;
+        entry.data[2] = data2;
+        entry.data[3] = data3;
+        entry.seq = bbData.head;
+        bbData.head++;
+    }
+
+private:
+    static uint32_t checksum();
+
+    static const uint32_t bbMagic = 0xB1AC0B0C;
+    static bool bbHadContent;
+
+    // In the .noinit section, see BlackBox.cpp.
+    static BlackBoxData bbData;
+};
+
+#endif /* BLACKBOX_H_ */
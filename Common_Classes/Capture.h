@@ -0,0 +1,165 @@
+/*
+ * Capture.h
+ *
+ *    Author:
+ *     Email:
+ *
+ * Triggered capture buffer ("oscilloscope mode"). The control ISR records an
+ * item in every cycle; the buffer keeps the last N items until a trigger
+ * occurs. Then it records the remaining post-trigger items and freezes, so
+ * that the background loop can dump the whole capture at leisure.
+ * States: Idle -> (arm) -> Armed -> (trigger) -> Triggered -> Complete ->
+ *         (release) -> Idle.
+ * Like RingBuffer, each variable has only one writer: the recording side
+ * (ISR) changes the state from Armed to Complete, the reading side only
+ * from Idle/Complete to Armed/Idle.
+ * Note: As it is a template class, the whole implementation is in this
+ *       header file.
+ */
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * System.h:                Memory barrier.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "System.h"
+
+
+enum CaptureState {CaptureIdle, CaptureArmed, CaptureTriggered,
+                   CaptureComplete};
+
+
+template <typename T, uint32_t N>
+class Capture
+{
+    // Power of 2 sizes allow cheap index wrapping with a mask.
+    static_assert((N >= 2) && ((N & (N - 1)) == 0),
+                  "Capture size must be a power of 2.");
+
+public:
+    void arm(uint32_t preTrigger)
+    {
+        /*
+         * Start a new capture. Must only be called by the reading side while
+         * the capture is idle or complete.
+         *
+         * preTrigger: Number of items before the trigger contained in the
+         *             capture (0 - N-1). Triggers are ignored until that
+         *             many items have been recorded.
+         */
+
+        if (preTrigger >= N)
+        {
+            preTrigger = N - 1;
+        }
+        capPreTrigger = preTrigger;
+        capHead = 0;
+
+        // Everything must be set before the ISR sees the new state.
+        System::memoryBarrier();
+        capState = CaptureArmed;
+    }
+
+    void release()
+    {
+        /*
+         * Discard a complete capture (f.ex. after dumping it) and stop
+         * recording. Must only be called by the reading side.
+         */
+
+        capState = CaptureIdle;
+    }
+
+    inline void record(const T &item, bool trigger)
+    {
+        /*
+         * Record one item. Must only be called by the recording side, once
+         * per cycle. Costs a copy of the item and a few comparisons.
+         *
+         * item:    The item to be copied into the buffer.
+         * trigger: Whether the trigger condition is met in this cycle.
+         */
+
+        CaptureState state = capState;
+        if ((state != CaptureArmed) && (state != CaptureTriggered))
+        {
+            return;
+        }
+
+        capItems[capHead & (N - 1)] = item;
+        capHead++;
+
+        if (state == CaptureArmed)
+        {
+            if (!trigger || (capHead <= capPreTrigger))
+            {
+                return;
+            }
+            capTrigger = capHead - 1;
+            capState = CaptureTriggered;
+        }
+
+        // The trigger item itself is the first post-trigger item.
+        if (capHead - capTrigger >= N - capPreTrigger)
+        {
+            // The items must be complete before the reader can see them.
+            System::memoryBarrier();
+            capState = CaptureComplete;
+        }
+    }
+
+    inline CaptureState getState()
+    {
+        /*
+         * Returns the current state of the capture.
+         */
+
+        return capState;
+    }
+
+    inline const T& get(uint32_t index)
+    {
+        /*
+         * Returns an item of a complete capture.
+         *
+         * index: 0 is the oldest item, the trigger item is at index
+         *        Capture::getTriggerIndex, the newest item at N-1.
+         */
+
+        return capItems[(capHead + index) & (N - 1)];
+    }
+
+    inline uint32_t getTriggerIndex()
+    {
+        /*
+         * Returns the index (see Capture::get) of the item which triggered
+         * the capture. This is the number of pre-trigger items.
+         */
+
+        return capPreTrigger;
+    }
+
+    inline uint32_t getSize()
+    {
+        /*
+         * Returns the number of items of a complete capture.
+         */
+
+        return N;
+    }
+
+private:
+    T capItems[N];
+    volatile CaptureState capState = CaptureIdle;
+    uint32_t capHead = 0;
+    uint32_t capTrigger = 0;
+    uint32_t capPreTrigger = 0;
+};
+
+#endif /* CAPTURE_H_ */
@@ -19,6 +19,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
 #include "driverlib/adc.h"
 #include "driverlib/gpio.h"
 #include "driverlib/pwm.h"
@@ -32,13 +33,53 @@
 
 // System
 #define CFG_SYS_FREQ                     40000000           // CPU clock
+#define CFG_SYS_STANDBY_FREQ             20000000           // CPU clock in standby to save power (see System::setClockFreq). CFG_SYS_FREQ keeps the clock.
+#define CFG_SYS_IDLE_SLEEP               true               // Sleep until the next interrupt when the background loop has nothing to do (see Monitor::sleep).
 
 #define CFG_DEBUG_TIMER_BASE             TIMER1_BASE        // Timer used to send debug data with a fixed frequency to the computer.
+#define CFG_DEBUG_TIMER_INT              INT_TIMER1A        // Interrupt of the debug timer.
 #define CFG_DEBUG_TIMER_FREQ             20                 // Frequency at which the computer receives new debug data.
+#define CFG_DEBUG_UART_INT               INT_UART0          // Interrupt of the USB UART used for the debug data.
+#define CFG_DEBUG_BAUD                   115200             // Baud rate of the USB UART. Up to 921600 or 1500000 if the PC supports it (see System::init).
+#define CFG_DEBUG_DMA                    true               // Transmit the binary telemetry with the uDMA (non-blocking, see System::enableDebugDMA).
+#define CFG_DEBUG_FORMAT                 DebugText          // DebugText for the Arduino serial plotter, DebugBinary or DebugCompressed for Tools/telemetry_decode.py (see System::sendDebugVals).
+
+#define CFG_SEGWAY_RECORD_BUFFER         16                 // Number of control cycle records that can be buffered for the background loop. Must be a power of 2.
+#define CFG_CAPTURE_ENABLE               true               // Record every control cycle and dump it via UART after a trigger (oscilloscope mode, see Capture.h).
+#define CFG_CAPTURE_SIZE                 128                // Number of control cycles per capture. Must be a power of 2. Each one needs 48 bytes of RAM.
+#define CFG_CAPTURE_PRETRIGGER           32                 // Number of control cycles before the trigger.
+#define CFG_CAPTURE_TRIG_ANGLE           0.26f              // Trigger if the absolute tilt angle exceeds this value [rad]. 0 disables this trigger.
+#define CFG_CAPTURE_TRIG_FOOTSWITCH      true               // Trigger on each edge of the foot switch.
+#define CFG_CAPTURE_TRIG_SATURATION      true               // Trigger if a motor duty cycle reaches +-CFG_CTLR_MAXDUTY.
+#define CFG_CAPTURE_REARM                true               // Arm the capture again after it has been dumped.
+#define CFG_CAPTURE_DUMP_LINES           2                  // Max. number of capture lines queued per background loop iteration (see Segway::dumpCapture).
+#define CFG_SYS_RESTART_ON_ERROR         true               // Restart the uC after CPU faults and sensor communication errors instead of halting (see System::setErrorRecoverable).
+#define CFG_SYS_STABLE_TIME              60                 // Time [s] of control cycles without an error after which the restarts are not counted as consecutive anymore (see BlackBox::clearRestarts).
+#define CFG_MON_IDLE_THRESHOLD           200                // Max. duration [cycles] of an uninterrupted background loop iteration. Longer iterations count as CPU load.
+#define CFG_RAMFUNC_ENABLE                                  // Execute the control ISR path from the SRAM instead of the flash (see RAMFUNC in System.h). Compare Update_Max_[cycles] with and without it.
+// #define CFG_PROFILER_ENABLE                                 // Measure the duration of each stage of Segway::update with the DWT cycle counter (see Profiler.h).
 
 
 // Main timer
 #define CFG_MAIN_TIMER_BASE              TIMER0_BASE        // Timer used to run the segway code.
+#define CFG_MAIN_TIMER_INT               INT_TIMER0A        // Interrupt of the main timer.
+
+
+// Interrupt priorities (see System::setIntPriority). Preemption priority 0 (highest) - 3 (lowest), subpriority 0 - 1.
+// Preemption priority 0 can't be masked by System::enterCritical. It is reserved for the foot switch, whose ISRs share only single flags with the rest (see Segway::footSwitchISR).
+// The clock change disables all interrupts for a moment, so they always see a consistent clock and time base (see System::setClockFreq).
+#define CFG_PRIO_MAIN_TIMER              1                  // The control loop must never wait for anything else.
+#define CFG_SUBPRIO_MAIN_TIMER           0
+#define CFG_PRIO_SENSOR_I2C              1                  // The sensor is part of the control loop.
+#define CFG_SUBPRIO_SENSOR_I2C           1
+#define CFG_PRIO_ADC                     2
+#define CFG_SUBPRIO_ADC                  0
+#define CFG_PRIO_UART                    3                  // Telemetry may be delayed by anything else.
+#define CFG_SUBPRIO_UART                 0
+#define CFG_PRIO_DEBUG_TIMER             3
+#define CFG_SUBPRIO_DEBUG_TIMER          1
+#define CFG_PRIO_FOOTSWITCH              0                  // Releasing the foot switch stops the motors at once, even during a control cycle.
+#define CFG_SUBPRIO_FOOTSWITCH           0
 
 
 // Motors
@@ -73,22 +114,48 @@
 #define CFG_FS_DIR                       GPIO_DIR_MODE_IN
 #define CFG_FS_PULLUP                    true               // active open between pin and GND
 #define CFG_FS_ACTIVE_STATE              1                  // Read value which means it's pushed
+#define CFG_FS_INT                       INT_GPIOB          // Interrupt of the port, wakes the uC from deep-sleep.
+#define CFG_FS_PRESS_DEBOUNCE_US         20000              // The foot switch must be pressed this long [us] before the segway leaves standby.
+#define CFG_FS_RELEASE_DEBOUNCE_US       500                // The foot switch must be released this long [us] before the motors are stopped. Keep it below 1ms.
+#define CFG_FS_DEBOUNCE_TIMER_BASE       TIMER2_BASE        // One-shot timer of the debouncing (see Segway::enableFootSwitchInt).
+#define CFG_FS_DEBOUNCE_TIMER_INT        INT_TIMER2A
 
 
 // Angle rate and acceleration sensor
 #define CFG_SENSOR_ADRESSBIT             0                  // State of the AD0 pin on the MPU6050
 #define CFG_SENSOR_I2C_MODULE            I2C1_BASE          // I2C1: PA6 = SCL, PA7 = SDA
+#define CFG_SENSOR_I2C_INT               INT_I2C1
 #define CFG_SENSOR_WHEEL_AXIS            'Y'
 #define CFG_SENSOR_HOR_AXIS              'Z'
 #define CFG_SENSOR_INVERT_ANGLE_RATE     false              // Rotating in driving direction is positive
 #define CFG_SENSOR_INVERT_HOR            true               // Driving direction is positive
 #define CFG_SENSOR_INVERT_VER            true               // Downwards is positive
+#define CFG_SENSOR_WAKE_PORT             GPIO_PORTB_BASE
+#define CFG_SENSOR_WAKE_PIN              GPIO_PIN_2         // Connected to the INT pin of the MPU6050 (motion wake, see MPU6050::sleep).
+#define CFG_SENSOR_WAKE_INT              INT_GPIOB
+
+
+// Deep-sleep after a long standby (see Segway::deepSleep)
+#define CFG_DEEPSLEEP_TIMEOUT            120                // Seconds in standby until the uC enters deep-sleep. 0 disables it.
+#define CFG_DEEPSLEEP_MOTION_WAKE        true               // Wake on motion of the segway, too (requires CFG_SENSOR_WAKE_PIN). Otherwise only the foot switch wakes it.
+#define CFG_DEEPSLEEP_MOTION_THRESHOLD   20                 // Acceleration change [2mg] that counts as motion.
+
+
+// Log of every control cycle on an external SPI NOR flash (see FlashLog.h)
+#define CFG_FLASHLOG_ENABLE              false              // Requires a flash connected to the SSI module below.
+#define CFG_FLASHLOG_SSI                 SSI0_BASE          // SSI0: PA2 = CLK, PA4 = MISO, PA5 = MOSI
+#define CFG_FLASHLOG_CS_PORT             GPIO_PORTA_BASE
+#define CFG_FLASHLOG_CS_PIN              GPIO_PIN_3         // Chip select (active low)
+#define CFG_FLASHLOG_BITRATE             10000000           // SPI clock [Hz]. Max. CFG_SYS_FREQ / 2.
+#define CFG_FLASHLOG_SIZE                0x400000           // Size of the flash [bytes], f.ex. 4MB for a W25Q32. Each control cycle needs ~30 bytes.
+#define CFG_FLASHLOG_PAGES               8                  // Page buffers (256 bytes each). Must cover the longest sector erase (up to 400ms).
 
 
 // Battery voltage
 #define CFG_BATT_BASE                    ADC0_BASE
 #define CFG_BATT_SSEQ                    0
 #define CFG_BATT_AIN                     ADC_CTL_CH1        // PE2
+#define CFG_BATT_INT                     INT_ADC0SS0
 #define CFG_BATT_MIN                     21.0f
 #define CFG_BATT_TIMEOUT                 5                  // Seconds until segway stops because of low battery.
 
@@ -97,6 +164,7 @@
 #define CFG_STEERING_BASE                ADC0_BASE
 #define CFG_STEERING_SSEQ                1
 #define CFG_STEERING_AIN                 ADC_CTL_CH2        // PE1
+#define CFG_STEERING_INT                 INT_ADC0SS1
 
 
 // Controller
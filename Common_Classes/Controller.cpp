@@ -44,6 +44,9 @@ void Controller::init(System *sys, float maxSpeed)
 
     ctlrMaxSpeed = maxSpeed;
 
+    // Monitor the current tilt angle.
+    ctlrDebugAngle = ctlrSys->registerDebugVal("Angle_[0.1deg]");
+
     // Initialize speed values
     resetSpeeds();
 }
@@ -59,6 +62,24 @@ void Controller::resetSpeeds()
     ctlrRightSpeed = 0.0f;
 }
 
+void Controller::resetAngle(float accelHor, float accelVer)
+{
+    /*
+     * Restart the angle estimation with the angle given by the
+     * accelerometer, f.ex. after the segway has been parked. Otherwise the
+     * complementary filter needs several seconds to forget the old angle.
+     * Speeds and speed limiter are reset, too.
+     *
+     * accel: Current accelerations in g (see Controller::updateValuesRad).
+     */
+
+    ctlrAngleRad = atan2f(-accelHor, -accelVer);
+    ctlrAngleRate = 0.0f;
+    ctlrAngleStableRad = 0.0f;
+    ctlrOverspeedInt = 0.0f;
+    resetSpeeds();
+}
+
 void Controller::updateValuesRad(float steeringValue, float angleRateRad,
                                  float accelHor, float accelVer)
 {
@@ -117,7 +138,7 @@ void Controller::updateValuesRad(float steeringValue, float angleRateRad,
     ctlrLeftSpeed  = ctlrTorque + ctlrDriveSpeed + steeringAdjusted;
     ctlrRightSpeed = ctlrTorque + ctlrDriveSpeed - steeringAdjusted;
 
-    ctlrSys->setDebugVal("Angle_[0.1deg]", ctlrAngleRad * 1800.0f / 3.14159f);
+    ctlrSys->setDebugVal(ctlrDebugAngle, ctlrAngleRad * 1800.0f / 3.14159f);
 }
 
 float Controller::getLeftSpeed()
@@ -168,6 +189,26 @@ float Controller::getRightSpeed()
     return ctlrRightSpeed;
 }
 
+float Controller::getAngleRad()
+{
+    /*
+     * Returns the current tilt angle estimated by the complementary filter
+     * in rad.
+     */
+
+    return ctlrAngleRad;
+}
+
+float Controller::getDriveSpeed()
+{
+    /*
+     * Returns the current (integrated) drive speed, in units of the duty
+     * cycle.
+     */
+
+    return ctlrDriveSpeed;
+}
+
 float Controller::getMaxSpeed()
 {
     return ctlrMaxSpeed;
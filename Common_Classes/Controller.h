@@ -33,18 +33,22 @@ public:
     ~Controller();
     void init(System *sys, float maxSpeed);
     void resetSpeeds();
-    void updateValuesRad(float steeringValue, float angleRate, float accelHor, float accelVer);
+    void resetAngle(float accelHor, float accelVer);
+    RAMFUNC void updateValuesRad(float steeringValue, float angleRate, float accelHor, float accelVer);
     float getLeftSpeed();
     float getRightSpeed();
+    float getAngleRad();
+    float getDriveSpeed();
     float getMaxSpeed();
     void setMaxSpeed(float speed);
 
 private:
-    float integrate(float last, float current);
-    float arcTanDeg(float a, float b);
-    float compFilter(float a, float b, float filterFactor);
+    RAMFUNC float integrate(float last, float current);
+    RAMFUNC float arcTanDeg(float a, float b);
+    RAMFUNC float compFilter(float a, float b, float filterFactor);
 
     System* ctlrSys;
+    DebugHandle ctlrDebugAngle;
     uint32_t ctlrFreq = 0;
     float ctlrAngleRad = 0.0f;
     float ctlrAngleRate = 0.0f;
@@ -0,0 +1,75 @@
+/*
+ * CycleCounter.h
+ *
+ *    Author:
+ *     Email:
+ *
+ * Access to the DWT cycle counter (CYCCNT) of the Cortex-M4 core. It counts
+ * every CPU clock cycle and therefore allows precise time measurements
+ * without using any peripheral of the uC.
+ * When compiled for the host (CFG_HOST_SIM defined) a stand-in counter based
+ * on the host's monotonic clock is used instead, scaled to CFG_SYS_FREQ.
+ */
+
+#ifndef CYCLECOUNTER_H_
+#define CYCLECOUNTER_H_
+
+
+/*
+ * stdint.h:                Variable definitions for the C99 standard
+ * inc/hw_types.h:          Macros for hardware access, both direct and via the
+ *                          bit-band region.
+ * chrono:                  (Host only) monotonic clock of the host system.
+ * Config.h:                (Host only) CFG_SYS_FREQ for the stand-in counter.
+ */
+#include <stdint.h>
+#ifdef CFG_HOST_SIM
+#include <chrono>
+#include "Config.h"
+#else
+#include "inc/hw_types.h"
+#endif
+
+
+// Registers of the Data Watchpoint and Trace unit ("Cortex-M4 Devices Generic
+// User Guide" and "ARMv7-M Architecture Reference Manual" C1.8)
+#define CYCLECOUNTER_DEMCR          0xE000EDFC  // Debug Exception and Monitor Control
+#define CYCLECOUNTER_DEMCR_TRCENA   0x01000000  // Enables the DWT unit
+#define CYCLECOUNTER_DWT_CTRL       0xE0001000  // DWT Control
+#define CYCLECOUNTER_DWT_CYCCNTENA  0x00000001  // Enables CYCCNT
+#define CYCLECOUNTER_DWT_CYCCNT     0xE0001004  // The cycle counter itself
+
+
+class CycleCounter
+{
+public:
+    static inline void init()
+    {
+        /*
+         * Enable the DWT unit and start its cycle counter. It can be called
+         * several times; the counter is not reset by this method.
+         */
+#ifndef CFG_HOST_SIM
+        HWREG(CYCLECOUNTER_DEMCR)    |= CYCLECOUNTER_DEMCR_TRCENA;
+        HWREG(CYCLECOUNTER_DWT_CTRL) |= CYCLECOUNTER_DWT_CYCCNTENA;
+#endif
+    }
+
+    static inline uint32_t get()
+    {
+        /*
+         * Return the current value of the cycle counter. It overflows after
+         * 2^32 cycles (~107s at 40MHz), therefore only differences of two
+         * readings (calculated with unsigned arithmetic) are meaningful.
+         */
+#ifdef CFG_HOST_SIM
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        return (uint32_t) (ns * (CFG_SYS_FREQ / 1000000) / 1000);
+#else
+        return HWREG(CYCLECOUNTER_DWT_CYCCNT);
+#endif
+    }
+};
+
+#endif /* CYCLECOUNTER_H_ */
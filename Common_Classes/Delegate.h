@@ -0,0 +1,103 @@
+/*
+ * Delegate.h
+ *
+ *    Author:
+ *     Email:
+ *
+ * Callback to a method of an object (or to a function) without a global
+ * helper function. It consists of the object pointer and a small stub
+ * function, which is generated by the compiler for each bound method. The
+ * method is therefore known at compile time and called directly by the stub
+ * (usually as a tail call); calling a delegate costs one indirect call, like
+ * a plain function pointer. No heap and no std::function are involved, a
+ * delegate is two words and can be copied freely.
+ *
+ * Example:
+ *   Delegate update = Delegate::bind<Segway, &Segway::update>(&segway);
+ *   update();                           // segway.update()
+ */
+
+#ifndef DELEGATE_H_
+#define DELEGATE_H_
+
+
+class Delegate
+{
+public:
+    Delegate()
+    {
+        /*
+         * Empty delegate, calling it does nothing.
+         */
+    }
+
+    template <class T, void (T::*Method)()>
+    static Delegate bind(T *object)
+    {
+        /*
+         * Returns a delegate calling object->Method().
+         */
+
+        return Delegate(object, &callMethod<T, Method>);
+    }
+
+    template <void (*Function)()>
+    static Delegate bind()
+    {
+        /*
+         * Returns a delegate calling the global function Function().
+         */
+
+        return Delegate(nullptr, &callFunction<Function>);
+    }
+
+    inline void operator()() const
+    {
+        /*
+         * Call the bound method or function.
+         */
+
+        dlStub(dlObject);
+    }
+
+private:
+    Delegate(void *object, void (*stub)(void*)) : dlObject(object),
+                                                   dlStub(stub)
+    {
+        /*
+         * Used by Delegate::bind.
+         */
+    }
+
+    template <class T, void (T::*Method)()>
+    static void callMethod(void *object)
+    {
+        /*
+         * Stub of Delegate::bind for methods.
+         */
+
+        (static_cast<T*>(object)->*Method)();
+    }
+
+    template <void (*Function)()>
+    static void callFunction(void *)
+    {
+        /*
+         * Stub of Delegate::bind for functions.
+         */
+
+        Function();
+    }
+
+    static void callNothing(void *)
+    {
+        /*
+         * Stub of an empty delegate.
+         */
+    }
+
+    void *dlObject = nullptr;
+    void (*dlStub)(void*) = callNothing;
+};
+
+#endif /* DELEGATE_H_ */
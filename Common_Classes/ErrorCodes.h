@@ -38,6 +38,12 @@ enum ErrorCodes
     MPUHorEqualsWheelAxis,  // char hor
 
     // Add custom codes here
+    SysWrongIntPriority,    // uint32_t interrupt, uint32_t preempt, uint32_t sub
+    FlashLogWrongConfig,    // uint32_t ssiBase, uint32_t size
+    FlashLogNotFound,       // uint32_t jedecId
+    CPUFault,               // uint32_t stacked[8] (r0-r3, r12, lr, pc, xPSR)
+    SysWrongSafeOutput,     // uint32_t portBase
+    TimerWrongFreq,         // uint32_t base, uint32_t freq or periodUS
 
 };
 
@@ -0,0 +1,618 @@
+/*
+ * FlashLog.cpp
+ *
+ *    Author:
+ *     Email:
+ *
+ * Log-structured logging to an external SPI NOR flash (see FlashLog.h).
+ */
+
+#include "FlashLog.h"
+
+
+// Storage of the static table (values in FlashLog.h), in the flash.
+constexpr uint32_t FlashLog::flConstants[4][8];
+
+
+#ifdef CFG_HOST_SIM
+uint8_t *FlashLog::flEmulated = 0;
+#endif
+
+FlashLog::FlashLog()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+FlashLog::~FlashLog()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+void FlashLog::init(System *sys, uint32_t ssiBase, uint32_t csPortBase,
+                    uint32_t csPin, uint32_t bitRate, uint32_t size)
+{
+    /*
+     * Initialize the SSI module and the uDMA channel, check whether the flash
+     * responds and find the end of the log by reading all sector headers.
+     * A new run starts at the next sector.
+     *
+     * sys:        Pointer to the current System instance. Needed for error
+     *             handling and the uDMA.
+     * ssiBase:    Base address of the SSI module (SSI0_BASE - SSI3_BASE).
+     *             CLK, RX and TX are the default pins of the module (see
+     *             flConstants).
+     * csPortBase: Port of the chip select pin (driven by software, as the
+     *             flash needs it active during the whole command).
+     * csPin:      Chip select pin.
+     * bitRate:    SPI clock in Hz (max. CPU clock / 2).
+     * size:       Size of the flash in bytes (multiple of the sector size,
+     *             max. 16MB with 3 byte addresses).
+     */
+
+    flSys = sys;
+    flSSIBase = ssiBase;
+    flSize = size;
+    flBitRate = bitRate;
+
+    if ((ssiBase < SSI0_BASE) || (ssiBase > SSI3_BASE)
+        || (ssiBase % 0x1000) || (size < 2 * FLASHLOG_SECTOR_SIZE)
+        || (size % FLASHLOG_SECTOR_SIZE) || (size > 0x1000000))
+    {
+        flSys->error(FlashLogWrongConfig, &ssiBase, &size);
+    }
+
+#ifdef CFG_HOST_SIM
+    // The emulated flash has no chip select pin.
+    (void) csPortBase;
+    (void) csPin;
+
+    // New flash chips are erased.
+    if (!flEmulated)
+    {
+        flEmulated = new uint8_t[size];
+        memset(flEmulated, 0xff, size);
+    }
+#else
+    // Determine which SSI module is used (hw_memmap.h).
+    uint8_t module = (ssiBase - SSI0_BASE) / 0x1000;
+
+    // Enable the SSI module and the GPIO port at once.
+    const uint32_t periphs[2] = {flConstants[module][flGPIOPeriph],
+                                 flConstants[module][flSSIPeriph]};
+    flSys->enablePeripherals(periphs, 2);
+
+    GPIOPinConfigure(flConstants[module][flCLKPinCfg]);
+    GPIOPinConfigure(flConstants[module][flRXPinCfg]);
+    GPIOPinConfigure(flConstants[module][flTXPinCfg]);
+    GPIOPinTypeSSI(flConstants[module][flGPIOBase],
+                   flConstants[module][flPins]);
+
+    // SPI mode 0, 8 bit frames (supported by all SPI NOR flashes).
+    SSIConfigSetExpClk(flSSIBase, flSys->getClockFreq(), SSI_FRF_MOTO_MODE_0,
+                       SSI_MODE_MASTER, bitRate, 8);
+    SSIEnable(flSSIBase);
+
+    flCS.init(flSys, csPortBase, csPin, GPIO_DIR_MODE_OUT);
+    deselect();
+
+    // The RX FIFO may contain data from before the reset.
+    uint32_t dummy;
+    while (SSIDataGetNonBlocking(flSSIBase, &dummy));
+
+    // The uDMA writes the pages into the TX FIFO whenever it is half empty.
+    flSys->initDMA();
+    flDMAChannel = flConstants[module][flDMAAssign] & 0x1f;
+    uDMAChannelAssign(flConstants[module][flDMAAssign]);
+    uDMAChannelAttributeDisable(flDMAChannel, UDMA_ATTR_ALL);
+    uDMAChannelControlSet(flDMAChannel | UDMA_PRI_SELECT,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE
+                          | UDMA_ARB_4);
+    SSIDMAEnable(flSSIBase, SSI_DMA_TX);
+#endif
+
+    // Check whether a flash responds (manufacturer and device ID).
+    select();
+    transfer(FLASHLOG_CMD_JEDEC_ID);
+    uint32_t jedecId = transfer(0) << 16;
+    jedecId |= transfer(0) << 8;
+    jedecId |= transfer(0);
+    deselect();
+    if ((jedecId == 0) || (jedecId == 0xffffff))
+    {
+        flSys->error(FlashLogNotFound, &jedecId);
+    }
+
+    /*
+     * Find the newest sector. Sequence numbers are compared with signed
+     * differences, so that an overflow does not matter.
+     */
+    bool found = false;
+    uint32_t newestAddress = 0;
+    FlashLogSector newest = {};
+    for (uint32_t address = 0; address < flSize; address += FLASHLOG_SECTOR_SIZE)
+    {
+        FlashLogSector header;
+        read(address, &header, sizeof(header));
+        if ((header.magic == FLASHLOG_MAGIC)
+            && (!found || ((int32_t) (header.seq - newest.seq) > 0)))
+        {
+            found = true;
+            newest = header;
+            newestAddress = address;
+        }
+    }
+
+    uint32_t start = 0;
+    if (found)
+    {
+        flSeq = newest.seq + 1;
+        flRun = newest.run + 1;
+        start = (newestAddress + FLASHLOG_SECTOR_SIZE) % flSize;
+    }
+    flPageAddress[flHead] = start;
+    flReady = true;
+}
+
+bool FlashLog::append(const void *data, uint32_t length)
+{
+    /*
+     * Append a record to the log. It is copied into the page buffers and
+     * programmed later (see FlashLog::process). If there is not enough space,
+     * the record is dropped and counted (see FlashLog::getDropped), false is
+     * returned.
+     *
+     * data:   Pointer to the first byte of the record.
+     * length: Number of bytes.
+     */
+
+    if (!flReady)
+    {
+        return false;
+    }
+
+    // The page at flHead can only be completed if there is another free page
+    // afterwards. A sector header may be needed, too.
+    uint32_t space = (flPageCount - 1 - flPagesFull) * FLASHLOG_PAGE_SIZE;
+    if (length + sizeof(FlashLogSector) + flFill > space)
+    {
+        flDropped++;
+        return false;
+    }
+
+    const uint8_t *bytes = (const uint8_t *) data;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        if ((flFill == 0) && (flPageAddress[flHead] % FLASHLOG_SECTOR_SIZE == 0))
+        {
+            if (i == 0)
+            {
+                putHeader(0, flRecords);
+            }
+            else
+            {
+                // The rest of this record comes first.
+                putHeader(length - i, flRecords + 1);
+            }
+        }
+
+        flPages[flHead][flFill++] = bytes[i];
+        if (flFill == FLASHLOG_PAGE_SIZE)
+        {
+            completePage();
+        }
+    }
+
+    flRecords++;
+    return true;
+}
+
+void FlashLog::flush()
+{
+    /*
+     * Hand the partially filled page to FlashLog::process, f.ex. at the end of
+     * a ride. The rest of it is padded with zeros (empty frames).
+     */
+
+    if (!flReady || (flFill == 0) || (flPagesFull >= flPageCount - 1))
+    {
+        return;
+    }
+
+    memset(&flPages[flHead][flFill], 0, FLASHLOG_PAGE_SIZE - flFill);
+    completePage();
+}
+
+void FlashLog::process()
+{
+    /*
+     * Program the full pages into the flash. Each call only checks the state
+     * of the current operation and starts the next one, it never waits for
+     * the flash. Must be called frequently from the background loop.
+     */
+
+    if (!flReady)
+    {
+        return;
+    }
+
+    switch (flState)
+    {
+    case FlashLogIdle:
+        if (flPagesFull)
+        {
+            uint32_t address = flPageAddress[flTail];
+            uint32_t sector = address - address % FLASHLOG_SECTOR_SIZE;
+
+            // Sectors are written in order, so each one is erased right
+            // before its first page.
+            if (sector != flErasedSector)
+            {
+                startErase(sector);
+                flErasedSector = sector;
+                flState = FlashLogErasing;
+            }
+            else
+            {
+                startProgram(flPages[flTail], address);
+                flState = FlashLogTransfer;
+            }
+        }
+        break;
+
+    case FlashLogErasing:
+        if (!isBusy())
+        {
+            flState = FlashLogIdle;
+        }
+        break;
+
+    case FlashLogTransfer:
+        if (programTransferred())
+        {
+            // The flash starts programming when the chip select is released.
+            deselect();
+            flState = FlashLogProgramming;
+        }
+        break;
+
+    case FlashLogProgramming:
+        if (!isBusy())
+        {
+            flTail = (flTail + 1) % flPageCount;
+            flPagesFull--;
+            flState = FlashLogIdle;
+        }
+        break;
+    }
+}
+
+void FlashLog::updateClock()
+{
+    /*
+     * Adapt the SPI clock to a new CPU clock (see System::setClockFreq). A
+     * page being sent is completed first. If the CPU clock is too low, the
+     * SPI clock is reduced to half of it.
+     * Note: Call it from the same context as FlashLog::process.
+     */
+
+    if (!flReady)
+    {
+        return;
+    }
+
+    while (flState == FlashLogTransfer)
+    {
+        process();
+    }
+
+#ifndef CFG_HOST_SIM
+    uint32_t clk = flSys->getClockFreq();
+    uint32_t bitRate = (flBitRate > clk / 2) ? clk / 2 : flBitRate;
+
+    while (SSIBusy(flSSIBase));
+    SSIDisable(flSSIBase);
+    SSIConfigSetExpClk(flSSIBase, clk, SSI_FRF_MOTO_MODE_0, SSI_MODE_MASTER,
+                       bitRate, 8);
+    SSIEnable(flSSIBase);
+#endif
+}
+
+bool FlashLog::isIdle()
+{
+    /*
+     * Returns true if no page is waiting or being programmed, i.e.
+     * FlashLog::process has nothing to do until the next FlashLog::append.
+     */
+
+    return (flState == FlashLogIdle) && !flPagesFull;
+}
+
+void FlashLog::read(uint32_t address, void *data, uint32_t length)
+{
+    /*
+     * Read data from the flash (blocking). Must not be called while a page is
+     * transferred (FlashLog::process).
+     *
+     * address: Address of the first byte.
+     * data:    Destination.
+     * length:  Number of bytes.
+     */
+
+    uint8_t *bytes = (uint8_t *) data;
+
+    select();
+    command(FLASHLOG_CMD_READ, address, true);
+    for (uint32_t i = 0; i < length; i++)
+    {
+        bytes[i] = transfer(0);
+    }
+    deselect();
+}
+
+uint16_t FlashLog::getRun()
+{
+    /*
+     * Returns the number of the current run (incremented on every boot).
+     */
+
+    return flRun;
+}
+
+uint32_t FlashLog::getRecords()
+{
+    /*
+     * Returns the number of records appended in this run.
+     */
+
+    return flRecords;
+}
+
+uint32_t FlashLog::getDropped()
+{
+    /*
+     * Returns the number of records which have been dropped because the
+     * page buffers were full (f.ex. during a long sector erase).
+     */
+
+    return flDropped;
+}
+
+void FlashLog::putHeader(uint16_t firstOffset, uint32_t firstRecord)
+{
+    /*
+     * Start a new sector with its header (see FlashLogSector). Must only be
+     * called at the beginning of the first page of a sector.
+     *
+     * firstOffset: Bytes until the first record starting in this sector.
+     * firstRecord: Number of this record.
+     */
+
+    FlashLogSector header;
+    header.magic = FLASHLOG_MAGIC;
+    header.seq = flSeq++;
+    header.run = flRun;
+    header.firstOffset = firstOffset;
+    header.firstRecord = firstRecord;
+
+    memcpy(flPages[flHead], &header, sizeof(header));
+    flFill = sizeof(header);
+}
+
+void FlashLog::completePage()
+{
+    /*
+     * Queue the page at flHead for programming and start filling the next
+     * one.
+     */
+
+    uint32_t address = (flPageAddress[flHead] + FLASHLOG_PAGE_SIZE) % flSize;
+
+    flPagesFull++;
+    flHead = (flHead + 1) % flPageCount;
+    flPageAddress[flHead] = address;
+    flFill = 0;
+}
+
+void FlashLog::select()
+{
+    /*
+     * Activate the chip select (active low). Every command starts with it.
+     */
+
+#ifdef CFG_HOST_SIM
+    flEmuCount = 0;
+#else
+    flCS.write(false);
+#endif
+}
+
+void FlashLog::deselect()
+{
+    /*
+     * Release the chip select, which ends the current command. Erase and
+     * program commands start at this point.
+     */
+
+#ifdef CFG_HOST_SIM
+    if (flEmuCommand == FLASHLOG_CMD_WRITE_ENABLE)
+    {
+        flEmuWriteEnabled = true;
+    }
+    else if ((flEmuCommand == FLASHLOG_CMD_SECTOR_ERASE) && flEmuWriteEnabled
+             && (flEmuCount >= 4))
+    {
+        uint32_t sector = flEmuAddress % flSize;
+        memset(&flEmulated[sector - sector % FLASHLOG_SECTOR_SIZE], 0xff,
+               FLASHLOG_SECTOR_SIZE);
+        flEmuWriteEnabled = false;
+    }
+    else if (flEmuCommand == FLASHLOG_CMD_PAGE_PROGRAM)
+    {
+        flEmuWriteEnabled = false;
+    }
+    flEmuCommand = 0;
+#else
+    flCS.write(true);
+#endif
+}
+
+uint8_t FlashLog::transfer(uint8_t value)
+{
+    /*
+     * Send one byte and return the byte received at the same time (blocking).
+     *
+     * value: Byte to send.
+     */
+
+#ifdef CFG_HOST_SIM
+    uint8_t result = 0xff;
+    if (flEmuCount == 0)
+    {
+        flEmuCommand = value;
+        flEmuAddress = 0;
+    }
+    else if (flEmuCommand == FLASHLOG_CMD_JEDEC_ID)
+    {
+        // Winbond W25Q32
+        const uint8_t id[3] = {0xef, 0x40, 0x16};
+        result = (flEmuCount <= 3) ? id[flEmuCount - 1] : 0xff;
+    }
+    else if (flEmuCommand == FLASHLOG_CMD_READ_STATUS)
+    {
+        // Erasing and programming is instantaneous.
+        result = flEmuWriteEnabled ? 0x02 : 0x00;
+    }
+    else if (flEmuCount <= 3)
+    {
+        flEmuAddress = (flEmuAddress << 8) | value;
+    }
+    else if (flEmuCommand == FLASHLOG_CMD_READ)
+    {
+        result = flEmulated[(flEmuAddress + flEmuCount - 4) % flSize];
+    }
+    else if ((flEmuCommand == FLASHLOG_CMD_PAGE_PROGRAM) && flEmuWriteEnabled)
+    {
+        // Wraps around within the page, like the real flash.
+        uint32_t address = flEmuAddress - flEmuAddress % FLASHLOG_PAGE_SIZE
+                           + (flEmuAddress + flEmuCount - 4) % FLASHLOG_PAGE_SIZE;
+        flEmulated[address % flSize] &= value;
+    }
+    flEmuCount++;
+    return result;
+#else
+    uint32_t received;
+    SSIDataPut(flSSIBase, value);
+    SSIDataGet(flSSIBase, &received);
+    return received;
+#endif
+}
+
+void FlashLog::command(uint8_t cmd, uint32_t address, bool withAddress)
+{
+    /*
+     * Send a command byte and optionally a 3 byte address (MSB first). The
+     * chip select must be active.
+     *
+     * cmd:         FLASHLOG_CMD_...
+     * address:     Address in the flash.
+     * withAddress: Whether the command needs an address.
+     */
+
+    transfer(cmd);
+    if (withAddress)
+    {
+        transfer(address >> 16);
+        transfer(address >> 8);
+        transfer(address);
+    }
+}
+
+bool FlashLog::isBusy()
+{
+    /*
+     * Returns true while the flash is erasing or programming.
+     */
+
+    select();
+    command(FLASHLOG_CMD_READ_STATUS, 0, false);
+    uint8_t status = transfer(0);
+    deselect();
+
+    return status & FLASHLOG_STATUS_BUSY;
+}
+
+void FlashLog::startErase(uint32_t address)
+{
+    /*
+     * Start erasing a sector. The flash is busy afterwards (up to 400ms,
+     * typically 45ms, see FlashLog::isBusy).
+     *
+     * address: Address of the sector.
+     */
+
+    select();
+    command(FLASHLOG_CMD_WRITE_ENABLE, 0, false);
+    deselect();
+
+    select();
+    command(FLASHLOG_CMD_SECTOR_ERASE, address, true);
+    deselect();
+}
+
+void FlashLog::startProgram(const uint8_t *page, uint32_t address)
+{
+    /*
+     * Start programming a page. Command and address are sent directly, the
+     * page data by the uDMA (see FlashLog::programTransferred). The chip
+     * select stays active until the transfer is complete.
+     *
+     * page:    The data of the page (FLASHLOG_PAGE_SIZE bytes).
+     * address: Address of the page.
+     */
+
+    select();
+    command(FLASHLOG_CMD_WRITE_ENABLE, 0, false);
+    deselect();
+
+    select();
+    command(FLASHLOG_CMD_PAGE_PROGRAM, address, true);
+
+#ifdef CFG_HOST_SIM
+    for (uint32_t i = 0; i < FLASHLOG_PAGE_SIZE; i++)
+    {
+        transfer(page[i]);
+    }
+#else
+    uDMAChannelTransferSet(flDMAChannel | UDMA_PRI_SELECT, UDMA_MODE_BASIC,
+                           (void *) page, (void *) (flSSIBase + SSI_O_DR),
+                           FLASHLOG_PAGE_SIZE);
+    uDMAChannelEnable(flDMAChannel);
+#endif
+}
+
+bool FlashLog::programTransferred()
+{
+    /*
+     * Returns true when the uDMA transfer of FlashLog::startProgram is
+     * complete and the last byte has left the SSI.
+     */
+
+#ifndef CFG_HOST_SIM
+    if (uDMAChannelIsEnabled(flDMAChannel) || SSIBusy(flSSIBase))
+    {
+        return false;
+    }
+
+    // Nothing is read during the transfer; discard what has been received
+    // (the RX FIFO overflowed, which has no other effect).
+    uint32_t dummy;
+    while (SSIDataGetNonBlocking(flSSIBase, &dummy));
+    SSIIntClear(flSSIBase, SSI_RXOR);
+#endif
+
+    return true;
+}
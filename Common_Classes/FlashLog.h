@@ -0,0 +1,193 @@
+/*
+ * FlashLog.h
+ *
+ *    Author:
+ *     Email:
+ *
+ * Log of high-rate data (f.ex. every control cycle) on an external SPI NOR
+ * flash (JEDEC standard commands, f.ex. W25Q32) connected to one of the SSI
+ * modules. The RAM only holds a few seconds of data (see Capture.h), the
+ * flash several minutes.
+ *
+ * Records (usually TelemetryFrame frames) are appended to RAM page buffers.
+ * Full pages are programmed in the background (FlashLog::process) while the
+ * uDMA feeds the SSI, so appending never waits for the flash.
+ * The flash is written like a log: sector after sector, wrapping around at
+ * the end and erasing the oldest sector right before it is written again.
+ * Therefore all sectors are erased equally often (wear leveling) and only the
+ * oldest data is lost once the flash is full.
+ *
+ * Every sector starts with a header (FlashLogSector). The headers form the
+ * index of the log: Reading only them gives the order of the sectors (seq),
+ * the runs (one per boot) and the number of the first record in each sector,
+ * so a reader can seek to any record without reading the whole flash (see
+ * Tools/flashlog_read.py). Partially written pages are padded with zeros,
+ * which are empty frames for the COBS decoder.
+ *
+ * When compiled for the host (CFG_HOST_SIM defined) the flash is emulated in
+ * RAM (including the NOR semantics: programming can only clear bits, erasing
+ * sets a whole sector to 0xff).
+ * Note: FlashLog::append, FlashLog::flush and FlashLog::process must be
+ *       called from the same context (the background loop).
+ */
+
+#ifndef FLASHLOG_H_
+#define FLASHLOG_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * string.h:                memcpy/memset for the page buffers.
+ * inc/hw_memmap.h:         Macros defining the memory map of the Tiva C Series
+ *                          device. This includes defines such as peripheral
+ *                          base address locations such as GPIO_PORTF_BASE.
+ * inc/hw_ssi.h:            Defines for the SSI register offsets (data
+ *                          register as DMA destination).
+ * driverlib/pin_map.h:     Mapping of peripherals to pins for all parts.
+ * driverlib/sysctl.h:      Defines and macros for the System Control API of
+ *                          DriverLib. This includes API functions such as
+ *                          SysCtlClockSet.
+ * driverlib/ssi.h:         Defines and macros for the SSI API of DriverLib.
+ * driverlib/udma.h:        Defines and macros for the uDMA API of DriverLib.
+ * driverlib/gpio.h:        Defines and macros for GPIO API of DriverLib. This
+ *                          includes API functions such as GPIOPinConfigure.
+ * Config.h:                Number of page buffers (CFG_FLASHLOG_PAGES).
+ * System.h:                Access to current CPU clock, uDMA and error
+ *                          handling.
+ * GPIO.h:                  Chip select of the flash.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_ssi.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/ssi.h"
+#include "driverlib/udma.h"
+#include "driverlib/gpio.h"
+#include "Config.h"
+#include "System.h"
+#include "GPIO.h"
+
+
+// Geometry of the flash
+#define FLASHLOG_PAGE_SIZE      256     // Max. bytes per page program command
+#define FLASHLOG_SECTOR_SIZE    4096    // Smallest erasable unit
+
+// Commands (JEDEC standard, f.ex. "W25Q32FV datasheet", chapter
+// "Instructions")
+#define FLASHLOG_CMD_WRITE_ENABLE   0x06
+#define FLASHLOG_CMD_READ_STATUS    0x05
+#define FLASHLOG_CMD_READ           0x03
+#define FLASHLOG_CMD_PAGE_PROGRAM   0x02
+#define FLASHLOG_CMD_SECTOR_ERASE   0x20
+#define FLASHLOG_CMD_JEDEC_ID       0x9f
+#define FLASHLOG_STATUS_BUSY        0x01    // Erase/program in progress
+
+// "FLOG" in little endian
+#define FLASHLOG_MAGIC              0x474f4c46
+
+
+struct FlashLogSector
+{
+    uint32_t magic;         // FLASHLOG_MAGIC
+    uint32_t seq;           // Number of the sector in write order
+    uint16_t run;           // Incremented on every boot
+    uint16_t firstOffset;   // Bytes (after the header) until the first record
+                            // starting in this sector
+    uint32_t firstRecord;   // Number of this record within the run
+};
+
+enum FlashLogState {FlashLogIdle,           // Nothing to do
+                    FlashLogErasing,        // Sector erase running
+                    FlashLogTransfer,       // uDMA sends a page to the flash
+                    FlashLogProgramming};   // Flash programs the page
+
+
+class FlashLog
+{
+public:
+    FlashLog();
+    ~FlashLog();
+    void init(System *sys, uint32_t ssiBase, uint32_t csPortBase,
+              uint32_t csPin, uint32_t bitRate, uint32_t size);
+    bool append(const void *data, uint32_t length);
+    void flush();
+    void process();
+    void updateClock();
+    bool isIdle();
+    void read(uint32_t address, void *data, uint32_t length);
+    uint16_t getRun();
+    uint32_t getRecords();
+    uint32_t getDropped();
+
+private:
+    void putHeader(uint16_t firstOffset, uint32_t firstRecord);
+    void completePage();
+    void select();
+    void deselect();
+    uint8_t transfer(uint8_t value);
+    void command(uint8_t cmd, uint32_t address, bool withAddress);
+    bool isBusy();
+    void startErase(uint32_t address);
+    void startProgram(const uint8_t *page, uint32_t address);
+    bool programTransferred();
+
+    System *flSys;
+    GPIO flCS;
+    uint32_t flSSIBase;
+    uint32_t flDMAChannel;
+    uint32_t flBitRate = 0;
+    uint32_t flSize = 0;
+    bool flReady = false;
+
+    // Position of the log
+    uint32_t flSeq = 0;
+    uint16_t flRun = 0;
+    uint32_t flRecords = 0;
+    uint32_t flDropped = 0;
+    uint32_t flErasedSector = 0xffffffff;
+
+    /*
+     * Page buffers, used as a queue: flPagesFull full pages starting at
+     * flTail wait for being programmed, the page at flHead is being filled.
+     */
+    const static uint32_t flPageCount = CFG_FLASHLOG_PAGES;
+    uint8_t flPages[flPageCount][FLASHLOG_PAGE_SIZE];
+    uint32_t flPageAddress[flPageCount];
+    uint32_t flHead = 0, flTail = 0, flPagesFull = 0;
+    uint32_t flFill = 0;
+    FlashLogState flState = FlashLogIdle;
+
+#ifdef CFG_HOST_SIM
+    // Emulated flash: memory (kept like the real flash when a new object is
+    // initialized, f.ex. to simulate a reboot) and state of the command.
+    static uint8_t *flEmulated;
+    uint8_t flEmuCommand = 0;
+    uint32_t flEmuCount = 0, flEmuAddress = 0;
+    bool flEmuWriteEnabled = false;
+#endif
+
+    // Constant tables are static, so they stay in the flash instead of being
+    // copied into every object by the constructor.
+    static constexpr uint8_t flSSIPeriph = 0, flGPIOPeriph = 1, flGPIOBase = 2,
+                             flPins = 3, flCLKPinCfg = 4, flRXPinCfg = 5,
+                             flTXPinCfg = 6, flDMAAssign = 7;
+    static constexpr uint32_t flConstants[4][8] =
+                 {{SYSCTL_PERIPH_SSI0, SYSCTL_PERIPH_GPIOA, GPIO_PORTA_BASE,
+                   GPIO_PIN_2 | GPIO_PIN_4 | GPIO_PIN_5, GPIO_PA2_SSI0CLK,
+                   GPIO_PA4_SSI0RX, GPIO_PA5_SSI0TX, UDMA_CH11_SSI0TX},
+                  {SYSCTL_PERIPH_SSI1, SYSCTL_PERIPH_GPIOF, GPIO_PORTF_BASE,
+                   GPIO_PIN_2 | GPIO_PIN_0 | GPIO_PIN_1, GPIO_PF2_SSI1CLK,
+                   GPIO_PF0_SSI1RX, GPIO_PF1_SSI1TX, UDMA_CH25_SSI1TX},
+                  {SYSCTL_PERIPH_SSI2, SYSCTL_PERIPH_GPIOB, GPIO_PORTB_BASE,
+                   GPIO_PIN_4 | GPIO_PIN_6 | GPIO_PIN_7, GPIO_PB4_SSI2CLK,
+                   GPIO_PB6_SSI2RX, GPIO_PB7_SSI2TX, UDMA_CH13_SSI2TX},
+                  {SYSCTL_PERIPH_SSI3, SYSCTL_PERIPH_GPIOD, GPIO_PORTD_BASE,
+                   GPIO_PIN_0 | GPIO_PIN_2 | GPIO_PIN_3, GPIO_PD0_SSI3CLK,
+                   GPIO_PD2_SSI3RX, GPIO_PD3_SSI3TX, UDMA_CH15_SSI3TX}};
+};
+
+#endif /* FLASHLOG_H_ */
@@ -8,6 +8,10 @@
 #include "GPIO.h"
 
 
+// Storage of the static table (values in GPIO.h), in the flash.
+constexpr uint32_t GPIO::gpioHalfCurrentToParam[7];
+
+
 GPIO::GPIO()
 {
     /*
@@ -53,10 +57,10 @@ void GPIO::init(System* sys, uint32_t portBase, uint32_t pin, uint32_t dir, bool
     gpioPinType = GPIO_PIN_TYPE_STD;
 
     /*
-     * Enable the peripheral (here: a GPIO port). This can be redone for other
-     * pins in the same port, as only one bit is set in a register. Therefore
-     * no need to check whether the bit is already set (simpler and faster
-     * without unnecessary check).
+     * Enable the peripheral (here: a GPIO port) and wait until it is ready.
+     * This can be redone for other pins in the same port, as only one bit is
+     * set in a register. Therefore no need to check whether the bit is
+     * already set (simpler and faster without unnecessary check).
      *
      * Note: In this class sometimes a mapping of values is needed. For example
      *       in this case the base address of the port must be mapped to the
@@ -68,31 +72,27 @@ void GPIO::init(System* sys, uint32_t portBase, uint32_t pin, uint32_t dir, bool
     switch (portBase)
     {
     case GPIO_PORTA_BASE:
-        SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
+        gpioSys->enablePeripheral(SYSCTL_PERIPH_GPIOA);
         break;
     case GPIO_PORTB_BASE:
-        SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
+        gpioSys->enablePeripheral(SYSCTL_PERIPH_GPIOB);
         break;
     case GPIO_PORTC_BASE:
-        SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOC);
+        gpioSys->enablePeripheral(SYSCTL_PERIPH_GPIOC);
         break;
     case GPIO_PORTD_BASE:
-        SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOD);
+        gpioSys->enablePeripheral(SYSCTL_PERIPH_GPIOD);
         break;
     case GPIO_PORTE_BASE:
-        SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
+        gpioSys->enablePeripheral(SYSCTL_PERIPH_GPIOE);
         break;
     case GPIO_PORTF_BASE:
-        SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
+        gpioSys->enablePeripheral(SYSCTL_PERIPH_GPIOF);
         break;
     default:
         gpioSys->error(GPIOWrongConfig, &portBase, &pin, &dir);
     }
 
-    // Wait until peripheral is enabled "TivaWare(TM) Treiberbibliothek"
-    // page 502, "TivaC Launchpad Workshop" page 78)
-    gpioSys->delayCycles(5);
-
     // Configure pin as input or output.
     GPIODirModeSet(gpioPortBase, gpioPin, gpioDir);
 
@@ -101,51 +101,6 @@ void GPIO::init(System* sys, uint32_t portBase, uint32_t pin, uint32_t dir, bool
     setPullup(pullup);
 }
 
-bool GPIO::read()
-{
-    /*
-     * Reads the pin associated with this GPIO object and returns that value.
-     */
-
-    /*
-     * GPIOPinRead reads the whole port, masked by the pins we want to read.
-     * This value is non-zero (which means true) if the pin is set, and 0
-     * (which means false) if not.
-     * Notes:
-     *  - The & 0xff is necessary because the upper 24 bits are _not_ masked
-     *    by GPIOPinRead. This has to do with how GPIO masking is done in
-     *    hardware.
-     *  - This trick only works if the reading is (implicitly) converted to
-     *    a bool. if (read == true) does not work because "true" is defined
-     *    as 1 and (f.ex.) 0b00010000 != 1. If you want to use an if, you
-     *    need to omit the == true or type cast the reading to a bool.
-     *    However all of this is unnecessarily complex.
-     * Example: GPIO port A state: 0b01001110
-     *          - GPIOPinRead(GPIO_PORTA_BASE, GPIO_PIN_3) returns
-     *            0b00001000 != 0 which means "true"
-     *          - GPIOPinRead(GPIO_PORTA_BASE, GPIO_PIN_7) returns 0b00000000
-     *            which means "false"
-     */
-    return (GPIOPinRead(gpioPortBase, gpioPin) & 0xff);
-}
-
-void GPIO::write(bool state)
-{
-    /*
-     * Writes a bit to the pin associated with this object.
-     * state: the desired value for the pin
-     */
-
-    /*
-     * GPIOPinWrite writes the indicated bits of a given value to the GPIO port
-     * (see "TivaWare(TM) Treiberbibliothek" page 280), thus manipulates only
-     * the indicated pins corresponding to that value.
-     * Here we only want to set one pin to a given state. Therefore we give
-     * only that pin as mask, and our value contains only the bit for that pin.
-     */
-    GPIOPinWrite(gpioPortBase, gpioPin, (state * gpioPin));
-}
-
 uint32_t GPIO::getCurrent()
 {
     /*
@@ -14,6 +14,7 @@
  * stdint.h:                Variable definitions for the C99 standard
  * inc/hw_types.h:          Macros for hardware access, both direct and via the
  *                          bit-band region.
+ * inc/hw_gpio.h:           Defines for the GPIO register offsets.
  * inc/hw_memmap.h:         Macros defining the memory map of the Tiva C Series
  *                          device. This includes defines such as peripheral
  *                          base address locations such as GPIO_PORTF_BASE.
@@ -27,6 +28,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "inc/hw_types.h"
+#include "inc/hw_gpio.h"
 #include "inc/hw_memmap.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/gpio.h"
@@ -37,11 +39,58 @@ class GPIO
 {
 public:
     GPIO();
-    virtual ~GPIO();
+    ~GPIO();
     void init(System *sys, uint32_t portBase, uint32_t pin, uint32_t dir,
               bool pullup = false);
-    bool read();
-    void write(bool state);
+
+    inline bool read()
+    {
+        /*
+         * Reads the pin associated with this GPIO object and returns that
+         * value. Inline, as it is called in every control cycle.
+         */
+
+        /*
+         * The data register is accessed with the pin as address mask (like
+         * GPIOPinRead, see "TivaC Mikrocontroller Datenblatt" page 654): only
+         * the bit of our pin can be set. This value is non-zero (which means
+         * true) if the pin is set, and 0 (which means false) if not.
+         * Notes:
+         *  - This trick only works if the reading is (implicitly) converted to
+         *    a bool. if (read == true) does not work because "true" is defined
+         *    as 1 and (f.ex.) 0b00010000 != 1. If you want to use an if, you
+         *    need to omit the == true or type cast the reading to a bool.
+         * Example: GPIO port A state: 0b01001110
+         *          - Reading GPIO_PIN_3 returns 0b00001000 != 0 which means
+         *            "true"
+         *          - Reading GPIO_PIN_7 returns 0b00000000 which means "false"
+         */
+#ifdef CFG_HOST_SIM
+        return (GPIOPinRead(gpioPortBase, gpioPin) & 0xff);
+#else
+        return HWREG(gpioPortBase + GPIO_O_DATA + (gpioPin << 2));
+#endif
+    }
+
+    inline void write(bool state)
+    {
+        /*
+         * Writes a bit to the pin associated with this object.
+         * state: the desired value for the pin
+         */
+
+        /*
+         * Like GPIOPinWrite the pin is used as address mask of the data
+         * register (see "TivaWare(TM) Treiberbibliothek" page 280), thus only
+         * this pin is changed. Our value contains only the bit for that pin.
+         */
+#ifdef CFG_HOST_SIM
+        GPIOPinWrite(gpioPortBase, gpioPin, (state * gpioPin));
+#else
+        HWREG(gpioPortBase + GPIO_O_DATA + (gpioPin << 2)) = state * gpioPin;
+#endif
+    }
+
     uint32_t getCurrent();
     void setCurrent(uint32_t current);
     void setPullup(bool enabled);
@@ -51,14 +100,15 @@ private:
     System *gpioSys;
     uint32_t gpioPortBase, gpioPin, gpioDir, gpioCurrent, gpioPinType;
 
-    // Note: Index 0 should not occur; any value could be here.
-    const uint32_t gpioHalfCurrentToParam[7] = {0,
-                                                GPIO_STRENGTH_2MA,
-                                                GPIO_STRENGTH_4MA,
-                                                GPIO_STRENGTH_6MA,
-                                                GPIO_STRENGTH_8MA,
-                                                GPIO_STRENGTH_10MA,
-                                                GPIO_STRENGTH_12MA};
+    // Note: Index 0 should not occur; any value could be here. Static, so
+    //       it stays in the flash instead of being copied into every object.
+    static constexpr uint32_t gpioHalfCurrentToParam[7] = {0,
+                                                           GPIO_STRENGTH_2MA,
+                                                           GPIO_STRENGTH_4MA,
+                                                           GPIO_STRENGTH_6MA,
+                                                           GPIO_STRENGTH_8MA,
+                                                           GPIO_STRENGTH_10MA,
+                                                           GPIO_STRENGTH_12MA};
     void refreshConfig();
 };
 
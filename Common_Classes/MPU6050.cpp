@@ -8,6 +8,10 @@
 #include "MPU6050.h"
 
 
+// Storage of the static table (values in MPU6050.h), in the flash.
+constexpr uint32_t MPU6050::mpuConstants[4][7];
+
+
 MPU6050::MPU6050()
 {
     /*
@@ -54,13 +58,10 @@ void MPU6050::init(System *sys, uint32_t I2CBase, bool addressBit,
     // We use floats
     mpuSys->enableFPU();
 
-    // Enable the GPIO port with the I2C pins.
-    SysCtlPeripheralEnable(mpuConstants[mpuI2CModuleNum][mpuGPIOPeriph]);
-    SysCtlPeripheralEnable(mpuConstants[mpuI2CModuleNum][mpuI2CPeriph]);
-
-    // Wait until peripheral is enabled ("TivaWare(TM) Treiberbibliothek"
-    // page 502, "TivaC Launchpad Workshop" page 78)
-    mpuSys->delayCycles(5);
+    // Enable the I2C module and the GPIO port with the I2C pins at once.
+    const uint32_t periphs[2] = {mpuConstants[mpuI2CModuleNum][mpuGPIOPeriph],
+                                 mpuConstants[mpuI2CModuleNum][mpuI2CPeriph]};
+    mpuSys->enablePeripherals(periphs, 2);
 
     // Set pin types to I2C SCL/SDA pins.
     GPIOPinTypeI2CSCL(mpuConstants[mpuI2CModuleNum][mpuGPIOBase],
@@ -341,6 +342,87 @@ float MPU6050::getAccelVer()
     return (mpuAccelVerSign * rawAccelVer * mpuAccelRange) / (1 << 15);
 }
 
+void MPU6050::sleep(bool motionWake, uint8_t threshold)
+{
+    /*
+     * Reduce the power consumption of the MPU6050 while the segway is parked.
+     * All configuration registers keep their values.
+     * With motion wake the gyroscope is switched off and the accelerometer
+     * samples at 5Hz (cycle mode). Its INT pin goes high (until INT_STATUS
+     * is read) as soon as the acceleration changes by more than the
+     * threshold. Otherwise the MPU6050 sleeps completely.
+     * For more information see MPU6050 Register Map and Descriptions (motion
+     * detection: revision 3.2).
+     *
+     * motionWake: true to signal motion on the INT pin.
+     * threshold:  Motion threshold in 2mg.
+     */
+
+    if (motionWake)
+    {
+        // Latched, active high push-pull INT pin, cleared by reading
+        // INT_STATUS.
+        setRegister(MPU6050_INT_PIN_CFG, 0x20);
+
+        // Motion: threshold exceeded for at least 1ms. The high pass filter
+        // (5Hz) removes the gravity.
+        setRegister(MPU6050_MOT_THR, threshold);
+        setRegister(MPU6050_MOT_DUR, 1);
+        setRegister(MPU6050_ACCEL_CONFIG,
+                    getRegister(MPU6050_ACCEL_CONFIG) | 0x01);
+        setRegister(MPU6050_INT_ENABLE, 0x40);
+        getRegister(MPU6050_INT_STATUS);
+
+        // Wake-up frequency 5Hz, gyroscope axes in standby. Cycle mode with
+        // the internal oscillator and the temperature sensor disabled.
+        setRegister(MPU6050_PWR_MGMT_2, 0x47);
+        setRegister(MPU6050_PWR_MGMT_1, 0x28);
+    }
+    else
+    {
+        setRegister(MPU6050_PWR_MGMT_1, 0x40);
+    }
+}
+
+void MPU6050::wake()
+{
+    /*
+     * Leave the sleep or cycle mode (see MPU6050::sleep) and restore the
+     * configuration of MPU6050::init. The gyroscope delivers valid data
+     * after MPU6050::getStartupUS; meanwhile the caller can do other things.
+     */
+
+    // Clock source PLL with X axis gyroscope reference, all axes on.
+    setRegister(MPU6050_PWR_MGMT_1, 0x01);
+    setRegister(MPU6050_PWR_MGMT_2, 0x00);
+
+    // No interrupts and no high pass filter.
+    setRegister(MPU6050_INT_ENABLE, 0x00);
+    getRegister(MPU6050_INT_STATUS);
+    setRegister(MPU6050_ACCEL_CONFIG,
+                getRegister(MPU6050_ACCEL_CONFIG) & ~0x07);
+}
+
+uint32_t MPU6050::getStartupUS()
+{
+    /*
+     * Returns the time in microseconds after MPU6050::init or MPU6050::wake
+     * until the gyroscope delivers valid data.
+     */
+
+    return mpuStartupUS;
+}
+
+void MPU6050::updateClock()
+{
+    /*
+     * Adapt the I2C bit rate to a new CPU clock (see System::setClockFreq).
+     * Note: No transfer may be in progress.
+     */
+
+    I2CMasterInitExpClk(mpuI2CBase, mpuSys->getClockFreq(), true);
+}
+
 void MPU6050::setRegister(uint8_t reg, uint8_t val)
 {
     /*
@@ -42,6 +42,12 @@
 #define MPU6050_ACCEL_CONFIG 0x1c
 #define MPU6050_WHO_AM_I     0x75
 #define MPU6050_PWR_MGMT_1   0x6b
+#define MPU6050_PWR_MGMT_2   0x6c
+#define MPU6050_MOT_THR      0x1f
+#define MPU6050_MOT_DUR      0x20
+#define MPU6050_INT_PIN_CFG  0x37
+#define MPU6050_INT_ENABLE   0x38
+#define MPU6050_INT_STATUS   0x3a
 
 // Addresses of the registers with the MSB part (xxx_H) of the sensor values
 // The LSB part is always stored in xxx_H + 1
@@ -58,7 +64,7 @@ class MPU6050
 {
 public:
     MPU6050();
-    virtual ~MPU6050();
+    ~MPU6050();
     void init(System *sys, uint32_t I2CBase, bool addressBit,
               char wheelAxis = 'x', char horAxis = 'y');
     void setWheelAxis(char axis);
@@ -66,11 +72,15 @@ public:
     void angleRateInvertSign(bool invertSign);
     void accelHorInvertSign(bool invertSign);
     void accelVerInvertSign(bool invertSign);
-    float getAngleRate();
-    float getAccelHor();
-    float getAccelVer();
+    RAMFUNC float getAngleRate();
+    RAMFUNC float getAccelHor();
+    RAMFUNC float getAccelVer();
+    void updateClock();
+    void sleep(bool motionWake, uint8_t threshold = 20);
+    void wake();
+    uint32_t getStartupUS();
 private:
-    uint32_t getRegister(uint8_t reg);
+    RAMFUNC uint32_t getRegister(uint8_t reg);
     void setRegister(uint8_t reg, uint8_t val);
     System *mpuSys;
     uint32_t mpuI2CBase, mpuAddress;
@@ -80,12 +90,15 @@ private:
     float mpuAccelVerSign = 1.0f;
     uint8_t mpuAngleRateRegister, mpuAccelHorRegister, mpuAccelVerRegister;
     char mpuAxis;
-    const uint16_t mpuGyroRange = 250; // [/s]
-    const uint8_t mpuAccelRange = 2;        // [g]
-    const uint8_t mpuI2CPeriph = 0, mpuGPIOPeriph = 1, mpuGPIOBase = 2,
-                  mpuSCLPin = 3, mpuSDAPin = 4, mpuSCLPinCfg = 5,
-                  mpuSDAPinCfg = 6;
-    const uint32_t mpuConstants[4][7] =
+    // Constants are static, so they stay in the flash instead of being
+    // copied into every object by the constructor.
+    static constexpr uint16_t mpuGyroRange = 250;   // [/s]
+    static constexpr uint8_t mpuAccelRange = 2;     // [g]
+    static constexpr uint32_t mpuStartupUS = 30000; // Gyro start-up from sleep
+    static constexpr uint8_t mpuI2CPeriph = 0, mpuGPIOPeriph = 1,
+                             mpuGPIOBase = 2, mpuSCLPin = 3, mpuSDAPin = 4,
+                             mpuSCLPinCfg = 5, mpuSDAPinCfg = 6;
+    static constexpr uint32_t mpuConstants[4][7] =
                  {{SYSCTL_PERIPH_I2C0, SYSCTL_PERIPH_GPIOB, GPIO_PORTB_BASE,
                    GPIO_PIN_2, GPIO_PIN_3, GPIO_PB2_I2C0SCL, GPIO_PB3_I2C0SDA},
                   {SYSCTL_PERIPH_I2C1, SYSCTL_PERIPH_GPIOA, GPIO_PORTA_BASE,
@@ -0,0 +1,250 @@
+/*
+ * Monitor.cpp
+ *
+ *    Author:
+ *     Email:
+ *
+ * The Monitor class determines the CPU load and the stack usage of the uC.
+ */
+
+#include "Monitor.h"
+
+
+#ifndef CFG_HOST_SIM
+/*
+ * Symbols created by the linker for the .stack section (see
+ * tm4c123gh6pm.cmd and the "ARM Assembly Language Tools User's Guide").
+ * __stack is the lowest address of the stack, __STACK_END the address right
+ * above it. The stack grows downwards, from __STACK_END to __stack.
+ * Note: On the Cortex-M4 the main program and all interrupts share this
+ *       stack (MSP) as no process stack is used.
+ */
+extern "C" uint32_t __stack;
+extern "C" uint32_t __STACK_END;
+#endif
+
+
+Monitor::Monitor()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+Monitor::~Monitor()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+void Monitor::init(System *sys)
+{
+    /*
+     * Start the CPU load measurement and paint the unused stack.
+     *
+     * sys: Pointer to the current System instance. Needed for the clock
+     *      frequency and the debug values.
+     */
+
+    monSys = sys;
+
+    monDebugLoad     = monSys->registerDebugVal("CPU_Load_[0.1%]", DebugInt16);
+    monDebugSleep    = monSys->registerDebugVal("Sleep_[0.1%]", DebugInt16);
+    monDebugStack    = monSys->registerDebugVal("Stack_Max_[B]", DebugInt16);
+    monDebugISRStack = monSys->registerDebugVal("Stack_ISR_[B]", DebugInt16);
+
+    CycleCounter::init();
+    monLastIdle = CycleCounter::get();
+
+    paintStack();
+}
+
+void Monitor::idle()
+{
+    /*
+     * Idle time accounting. Must be called in the background loop, as often
+     * as possible.
+     */
+
+    uint32_t now = CycleCounter::get();
+    uint32_t delta = now - monLastIdle;
+    monLastIdle = now;
+
+    // Only uninterrupted loop iterations count as idle time.
+    if (delta <= CFG_MON_IDLE_THRESHOLD)
+    {
+        monIdleCycles += delta;
+    }
+    monWindowCycles += delta;
+
+    // Once per second the load is updated.
+    if (monWindowCycles >= monSys->getClockFreq())
+    {
+        // Load in 0.1%. Divide first to prevent an overflow.
+        monCPULoad = 1000 - monIdleCycles / (monWindowCycles / 1000);
+        monSleepRatio = monSleepCycles / (monWindowCycles / 1000);
+        monIdleCycles = 0;
+        monSleepCycles = 0;
+        monWindowCycles = 0;
+
+#ifndef CFG_HOST_SIM
+        // Depth of the stack inside the background loop. Everything beyond
+        // is caused by interrupts.
+        uint32_t marker;
+        uint32_t depth = (&__STACK_END - &marker) * sizeof(uint32_t);
+        if (depth > monBackgroundStackDepth)
+        {
+            monBackgroundStackDepth = depth;
+        }
+#endif
+
+        // The scan is not time critical, so it is done here, too.
+        monStackHighWater = scanStack();
+    }
+}
+
+void Monitor::sleep()
+{
+    /*
+     * Sleep until the next interrupt (sleep mode, "TivaC Mikrocontroller
+     * Datenblatt", chapter "Power Control") and count the time as idle time.
+     * Replaces spinning in the background loop; call it once the background
+     * tasks are done. Interrupts stay pending while the sleep time is
+     * measured and are handled right afterwards.
+     * Note: The DWT cycle counter stops while the core sleeps, therefore the
+     *       main timer (which wakes the CPU at least once per control cycle)
+     *       measures the sleep time.
+     */
+
+    // Everything up to now is accounted for.
+    idle();
+
+    IntMasterDisable();
+    uint32_t before = TimerValueGet(CFG_MAIN_TIMER_BASE, TIMER_A);
+    SysCtlSleep();
+    uint32_t after = TimerValueGet(CFG_MAIN_TIMER_BASE, TIMER_A);
+
+    // The timer counts down and may have been reloaded in between.
+    uint32_t slept = before - after;
+    if (after > before)
+    {
+        slept += TimerLoadGet(CFG_MAIN_TIMER_BASE, TIMER_A) + 1;
+    }
+    monIdleCycles += slept;
+    monSleepCycles += slept;
+    monWindowCycles += slept;
+    monLastIdle = CycleCounter::get();
+    IntMasterEnable();
+}
+
+void Monitor::publish()
+{
+    /*
+     * Hand the current figures to the System class so that they are
+     * transmitted with the other debug values.
+     * Note: Call this method from the same context as the other
+     *       System::setDebugVal calls (f.ex. Segway::update).
+     */
+
+    monSys->setDebugVal(monDebugLoad, monCPULoad);
+    monSys->setDebugVal(monDebugSleep, monSleepRatio);
+    monSys->setDebugVal(monDebugStack, monStackHighWater);
+    monSys->setDebugVal(monDebugISRStack, getISRStackHighWater());
+}
+
+uint32_t Monitor::getCPULoad()
+{
+    /*
+     * Returns the CPU load of the last second in 0.1%.
+     */
+
+    return monCPULoad;
+}
+
+uint32_t Monitor::getSleepRatio()
+{
+    /*
+     * Returns the share of the last second the CPU slept in 0.1%.
+     */
+
+    return monSleepRatio;
+}
+
+uint32_t Monitor::getStackSize()
+{
+    /*
+     * Returns the size of the stack in bytes as defined by the linker.
+     */
+
+#ifdef CFG_HOST_SIM
+    return 0;
+#else
+    return (&__STACK_END - &__stack) * sizeof(uint32_t);
+#endif
+}
+
+uint32_t Monitor::getStackHighWater()
+{
+    /*
+     * Returns the maximum stack usage in bytes since the initialization.
+     */
+
+    return monStackHighWater;
+}
+
+uint32_t Monitor::getISRStackHighWater()
+{
+    /*
+     * Returns the maximum stack usage in bytes caused by interrupts on top of
+     * the background loop.
+     */
+
+    if (monStackHighWater > monBackgroundStackDepth)
+    {
+        return monStackHighWater - monBackgroundStackDepth;
+    }
+    return 0;
+}
+
+void Monitor::paintStack()
+{
+    /*
+     * Fill the unused part of the stack (below the current stack pointer)
+     * with monStackPattern.
+     * Note: Interrupts can stay enabled. An ISR places its frame below the
+     *       current stack pointer, too, but has finished (and its frame is
+     *       unused again) before this loop continues.
+     */
+
+#ifndef CFG_HOST_SIM
+    // The address of a local variable is (nearly) the current stack pointer.
+    // Keep some distance to not overwrite the frame of this method.
+    uint32_t marker;
+    uint32_t *end = &marker - 16;
+
+    for (uint32_t *addr = &__stack; addr < end; addr++)
+    {
+        *addr = monStackPattern;
+    }
+#endif
+}
+
+uint32_t Monitor::scanStack()
+{
+    /*
+     * Returns the number of bytes of the stack which have been overwritten
+     * since painting.
+     */
+
+#ifdef CFG_HOST_SIM
+    return 0;
+#else
+    uint32_t *addr = &__stack;
+    while ((addr < &__STACK_END) && (*addr == monStackPattern))
+    {
+        addr++;
+    }
+    return (&__STACK_END - addr) * sizeof(uint32_t);
+#endif
+}
@@ -0,0 +1,84 @@
+/*
+ * Monitor.h
+ *
+ *    Author:
+ *     Email:
+ *
+ * The Monitor class determines the CPU load and the stack usage of the uC.
+ * - CPU load: The background loop calls Monitor::idle as often as possible.
+ *   Each call measures the time since the previous call with the DWT cycle
+ *   counter. If it is short the loop ran uninterrupted and this time counts
+ *   as idle time. If an interrupt occurred in between, the time counts as
+ *   busy time. Once per second the ratio is converted to a CPU load.
+ * - Sleep: Instead of spinning, the background loop can sleep until the next
+ *   interrupt (Monitor::sleep, WFI). The sleep time counts as idle time and
+ *   is reported separately; together with the CPU clock it determines the
+ *   idle current (see the "TivaC Mikrocontroller Datenblatt", chapter
+ *   "Electrical Characteristics", for the currents in run and sleep mode).
+ * - Stack: The unused part of the stack is painted with a known pattern at
+ *   initialization. Scanning for the first overwritten word gives the
+ *   maximum stack depth ever reached (high-water mark).
+ */
+
+#ifndef MONITOR_H_
+#define MONITOR_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * driverlib/timer.h:       Defines and macros for the Timer API of
+ *                          DriverLib. Here needed to measure the sleep time.
+ * Config.h:                All configurable parameters of the segway. Here
+ *                          needed for CFG_MON_IDLE_THRESHOLD and the main
+ *                          timer.
+ * System.h:                Access to current CPU clock and other functions.
+ * CycleCounter.h:          Access to the DWT cycle counter.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "driverlib/timer.h"
+#include "Config.h"
+#include "System.h"
+#include "CycleCounter.h"
+
+
+class Monitor
+{
+public:
+    Monitor();
+    ~Monitor();
+    void init(System *sys);
+    void idle();
+    void sleep();
+    void publish();
+    uint32_t getCPULoad();
+    uint32_t getSleepRatio();
+    uint32_t getStackSize();
+    uint32_t getStackHighWater();
+    uint32_t getISRStackHighWater();
+
+private:
+    void paintStack();
+    uint32_t scanStack();
+
+    System *monSys;
+    DebugHandle monDebugLoad, monDebugSleep, monDebugStack, monDebugISRStack;
+
+    // CPU load
+    uint32_t monLastIdle = 0;
+    uint32_t monIdleCycles = 0;
+    uint32_t monWindowCycles = 0;
+    volatile uint32_t monCPULoad = 0;
+
+    // Sleep
+    uint32_t monSleepCycles = 0;
+    volatile uint32_t monSleepRatio = 0;
+
+    // Stack
+    const static uint32_t monStackPattern = 0xDEADBEEF;
+    uint32_t monBackgroundStackDepth = 0;
+    volatile uint32_t monStackHighWater = 0;
+};
+
+#endif /* MONITOR_H_ */
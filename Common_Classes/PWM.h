@@ -23,6 +23,8 @@ class PWM
 {
 public:
     PWM();
+    // Stays virtual: the precompiled library expects a vtable pointer in
+    // front of spaceForLib.
     virtual ~PWM();
     void init(System *sys,uint32_t portBase, uint32_t pin1, uint32_t pin2,
               bool invert = false, uint32_t freq = 5000);
@@ -0,0 +1,148 @@
+/*
+ * Pin.h
+ *
+ *    Author:
+ *     Email:
+ *
+ * GPIO pins whose port and pins are known at compile time. The address of
+ * the data register masked with the pins (see "TivaC Mikrocontroller
+ * Datenblatt" page 654) is a constant, therefore reading or writing compiles
+ * to a single load or store; no driverlib call and no address computation.
+ * A mask with several pins of the same port is a port group, which is read
+ * or written in one operation (f.ex. both inputs of a motor driver).
+ * Unlike GPIO objects a Pin has no state, all methods are static. Objects can
+ * still be used as members to keep the call syntax of the GPIO class.
+ * When compiled for the host (CFG_HOST_SIM defined) the driverlib functions
+ * are used instead.
+ *
+ * Example:
+ *   Pin<GPIO_PORTF_BASE, GPIO_PIN_1 | GPIO_PIN_2> leds;
+ *   leds.init(sys, GPIO_DIR_MODE_OUT);
+ *   leds.writeBits(GPIO_PIN_1);         // PF1 high, PF2 low
+ */
+
+#ifndef PIN_H_
+#define PIN_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * inc/hw_types.h:          Macros for hardware access (HWREG).
+ * inc/hw_gpio.h:           Defines for the GPIO register offsets.
+ * driverlib/gpio.h:        Defines and macros for GPIO API of DriverLib. This
+ *                          includes API functions such as GPIODirModeSet.
+ * System.h:                Enables the GPIO port.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_types.h"
+#include "inc/hw_gpio.h"
+#include "driverlib/gpio.h"
+#include "System.h"
+
+
+template <uint32_t Port, uint8_t Mask>
+class Pin
+{
+public:
+    static void init(System *sys, uint32_t dir, bool pullup = false)
+    {
+        /*
+         * Enable the port and configure the pins as inputs or outputs with
+         * 2mA drive strength.
+         *
+         * sys:     Pointer to the current System object.
+         * dir:     GPIO_DIR_MODE_IN or GPIO_DIR_MODE_OUT.
+         * pullup:  Enable the internal weak pull-up. Default is disabled.
+         */
+
+        uint32_t periph = sys->getGPIOPeriph(Port);
+        if (!periph || !Mask)
+        {
+            uint32_t port = Port, mask = Mask;
+            sys->error(GPIOWrongConfig, &port, &mask, &dir);
+        }
+        sys->enablePeripheral(periph);
+        GPIODirModeSet(Port, Mask, dir);
+        GPIOPadConfigSet(Port, Mask, GPIO_STRENGTH_2MA,
+                         pullup ? GPIO_PIN_TYPE_STD_WPU : GPIO_PIN_TYPE_STD);
+    }
+
+    static inline bool read()
+    {
+        /*
+         * Returns true if any of the pins is high.
+         */
+
+        return readBits();
+    }
+
+    static inline void write(bool state)
+    {
+        /*
+         * Set all pins high (true) or low (false).
+         */
+
+        writeBits(state ? Mask : 0);
+    }
+
+    static inline uint32_t readBits()
+    {
+        /*
+         * Returns the state of all pins at once, as bits of the port (only
+         * the bits in Mask can be set).
+         */
+
+#ifdef CFG_HOST_SIM
+        return GPIOPinRead(Port, Mask) & Mask;
+#else
+        return HWREG(dataAddress);
+#endif
+    }
+
+    static inline void writeBits(uint32_t bits)
+    {
+        /*
+         * Set all pins at once. Bits outside of Mask are ignored; the other
+         * pins of the port are not changed.
+         *
+         * bits: New state as bits of the port.
+         */
+
+#ifdef CFG_HOST_SIM
+        GPIOPinWrite(Port, Mask, bits);
+#else
+        HWREG(dataAddress) = bits;
+#endif
+    }
+
+    static void takeOver(uint32_t bits)
+    {
+        /*
+         * Drive the pins as GPIO outputs with the given state, even if a
+         * peripheral controls them (alternate function, f.ex. PWM). Undone
+         * by Pin::release.
+         *
+         * bits: State as bits of the port.
+         */
+
+        writeBits(bits);
+        GPIODirModeSet(Port, Mask, GPIO_DIR_MODE_OUT);
+    }
+
+    static void release()
+    {
+        /*
+         * Hand the pins back to their peripheral (see Pin::takeOver).
+         */
+
+        GPIODirModeSet(Port, Mask, GPIO_DIR_MODE_HW);
+    }
+
+private:
+    // The address bits [9:2] select the pins which are accessed.
+    static const uint32_t dataAddress = Port + GPIO_O_DATA + (Mask << 2);
+};
+
+#endif /* PIN_H_ */
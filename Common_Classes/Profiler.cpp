@@ -0,0 +1,163 @@
+/*
+ * Profiler.cpp
+ *
+ *    Author:
+ *     Email:
+ *
+ * Lightweight profiler based on the DWT cycle counter.
+ */
+
+#include "Profiler.h"
+
+
+Profiler::Profiler()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+Profiler::~Profiler()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+#ifdef CFG_PROFILER_ENABLE
+
+const char* const Profiler::profStageNames[ProfStageCount] = {"Update",
+                                                              "Foot_Switch",
+                                                              "Steering",
+                                                              "MPU_Angle_Rate",
+                                                              "MPU_Accel_Hor",
+                                                              "MPU_Accel_Ver",
+                                                              "Controller",
+                                                              "PWM",
+                                                              "Debug_Vals"};
+
+void Profiler::init(System *sys)
+{
+    /*
+     * Initialize the profiler and start the cycle counter.
+     *
+     * sys: Pointer to the current System instance. Needed for the debug UART.
+     */
+
+    profSys = sys;
+
+    CycleCounter::init();
+
+    reset();
+}
+
+void Profiler::reset()
+{
+    /*
+     * Clear all statistics.
+     */
+
+    for (uint_fast8_t i = 0; i < ProfStageCount; i++)
+    {
+        profCount[i] = 0;
+        profSum[i]   = 0;
+        profMin[i]   = UINT32_MAX;
+        profMax[i]   = 0;
+        for (uint_fast8_t j = 0; j < profBuckets; j++)
+        {
+            profHist[i][j] = 0;
+        }
+    }
+}
+
+void Profiler::requestReport()
+{
+    /*
+     * Request the statistics to be sent. Can be called from any context
+     * (f.ex. an ISR); the transmission itself is done by sendReport which
+     * should be called from the background loop.
+     */
+
+    profReportRequested = true;
+}
+
+bool Profiler::reportRequested()
+{
+    /*
+     * Returns whether a report has been requested and not been sent yet.
+     */
+
+    return profReportRequested;
+}
+
+void Profiler::sendReport()
+{
+    /*
+     * Send the statistics of all stages that have been measured at least
+     * once via the debug UART. All values are given in CPU cycles.
+     * Transmission format (one line per stage):
+     *   PROF\t<Stage>\t<Count>\t<Min>\t<Mean>\t<Max>\t<Bucket_0>\t...\n
+     * Bucket i contains the number of measurements between 2^i and
+     * 2^(i+1)-1 cycles.
+     * Finally the cost of one text line of the current debug values is
+     * compared (see System::benchmarkDebugText).
+     *
+     * Note: Periodic debug values are paused meanwhile so that the lines
+     *       do not get mixed up. This takes a while, therefore do not call
+     *       it from an ISR. Only sent with the DebugText format (see
+     *       System::getDebugFormat).
+     */
+
+    profReportRequested = false;
+
+    if (profSys->getDebugFormat() != DebugText)
+    {
+        return;
+    }
+
+    bool debugging = profSys->getDebugging();
+    profSys->setDebugging(false);
+
+    UARTprintf("PROF\tStage\tCount\tMin\tMean\tMax\tHistogram\n");
+    for (uint_fast8_t i = 0; i < ProfStageCount; i++)
+    {
+        // Copy the values of the stage first because the ISR may modify
+        // them meanwhile. The critical section keeps them consistent (f.ex.
+        // the 64 bit sum is written with two stores).
+        uint32_t hist[profBuckets];
+        uint32_t state = profSys->enterCritical();
+        uint32_t count = profCount[i];
+        uint64_t sum = profSum[i];
+        uint32_t min = profMin[i];
+        uint32_t max = profMax[i];
+        for (uint_fast8_t j = 0; j < profBuckets; j++)
+        {
+            hist[j] = profHist[i][j];
+        }
+        profSys->exitCritical(state);
+
+        if (count == 0)
+        {
+            continue;
+        }
+        uint32_t mean = sum / count;
+
+        UARTprintf("PROF\t%s\t%u\t%u\t%u\t%u", profStageNames[i], count,
+                   min, mean, max);
+        for (uint_fast8_t j = 0; j < profBuckets; j++)
+        {
+            UARTprintf("\t%u", hist[j]);
+        }
+        UARTprintf("\n");
+    }
+
+    // Cost of one text line of debug values, TelemetryText vs. UARTprintf.
+    uint32_t formatterCycles, printfCycles;
+    profSys->benchmarkDebugText(formatterCycles, printfCycles);
+    UARTprintf("PROF\tText_Line\tFormatter\t%u\tUARTprintf\t%u\n",
+               formatterCycles, printfCycles);
+
+    profSys->setDebugging(debugging);
+}
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Profiler.h
+ *
+ *    Author:
+ *     Email:
+ *
+ * Lightweight profiler based on the DWT cycle counter. Code sections are
+ * marked with PROFILE_SCOPE; for each stage the minimum, maximum and mean
+ * duration as well as a histogram with logarithmic buckets (powers of 2) is
+ * kept in RAM. On request these statistics are sent via the debug UART.
+ * If CFG_PROFILER_ENABLE is not defined in Config.h, all markers compile to
+ * nothing and the Profiler class is empty.
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * Config.h:                All configurable parameters of the segway. Here
+ *                          needed for CFG_PROFILER_ENABLE.
+ * System.h:                Access to the debug UART and other functions.
+ * CycleCounter.h:          Access to the DWT cycle counter.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "Config.h"
+#include "System.h"
+#include "CycleCounter.h"
+
+
+enum ProfilerStage
+{
+    /*
+     * Note: If you add a stage, add its name to profStageNames in
+     *       Profiler.cpp, too.
+     */
+    ProfUpdate,             // Complete Segway::update
+    ProfFootSwitch,         // Reading the foot switch
+    ProfSteering,           // Reading the steering value
+    ProfMPUAngleRate,       // MPU6050 transaction for the angle rate
+    ProfMPUAccelHor,        // MPU6050 transaction for the horizontal accel
+    ProfMPUAccelVer,        // MPU6050 transaction for the vertical accel
+    ProfController,         // Controller::updateValuesRad
+    ProfPWM,                // Updating both motor duty cycles
+    ProfDebugVals,          // System::setDebugVal calls
+
+    // Add custom stages here
+
+    ProfStageCount
+};
+
+
+class Profiler
+{
+public:
+    Profiler();
+    ~Profiler();
+#ifdef CFG_PROFILER_ENABLE
+    void init(System *sys);
+    void reset();
+    void requestReport();
+    bool reportRequested();
+    void sendReport();
+
+    inline void record(ProfilerStage stage, uint32_t start)
+    {
+        /*
+         * Add the duration from start until now to the statistics of the
+         * given stage. Usually called by ProfilerScope.
+         *
+         * stage: The stage the measurement belongs to.
+         * start: Cycle counter value at the beginning of the measurement.
+         */
+
+        uint32_t cycles = CycleCounter::get() - start;
+
+        profCount[stage]++;
+        profSum[stage] += cycles;
+        if (cycles < profMin[stage])
+        {
+            profMin[stage] = cycles;
+        }
+        if (cycles > profMax[stage])
+        {
+            profMax[stage] = cycles;
+        }
+
+        // Bucket i contains all durations from 2^i to 2^(i+1)-1 cycles.
+        uint32_t bucket = 0;
+        while ((cycles >>= 1) && (bucket < profBuckets - 1))
+        {
+            bucket++;
+        }
+        profHist[stage][bucket]++;
+    }
+
+private:
+    const static uint32_t profBuckets = 24;
+    static const char* const profStageNames[ProfStageCount];
+
+    System *profSys;
+    volatile bool profReportRequested = false;
+    uint32_t profCount[ProfStageCount];
+    uint32_t profMin[ProfStageCount];
+    uint32_t profMax[ProfStageCount];
+    uint64_t profSum[ProfStageCount];
+    uint32_t profHist[ProfStageCount][profBuckets];
+#else
+    // Empty stubs; everything is optimized away when profiling is disabled.
+    inline void init(System *) {}
+    inline void reset() {}
+    inline void requestReport() {}
+    inline bool reportRequested() { return false; }
+    inline void sendReport() {}
+#endif
+};
+
+
+#ifdef CFG_PROFILER_ENABLE
+
+class ProfilerScope
+{
+    /*
+     * Measures the time between its construction and its destruction (end of
+     * the enclosing scope) and hands it to the given profiler.
+     */
+public:
+    inline ProfilerScope(Profiler &profiler, ProfilerStage stage)
+        : scopeProfiler(profiler), scopeStage(stage),
+          scopeStart(CycleCounter::get())
+    {
+    }
+
+    inline ~ProfilerScope()
+    {
+        scopeProfiler.record(scopeStage, scopeStart);
+    }
+
+private:
+    Profiler &scopeProfiler;
+    ProfilerStage scopeStage;
+    uint32_t scopeStart;
+};
+
+#define PROFILE_SCOPE(profiler, stage) \
+    ProfilerScope profilerScope_##stage((profiler), (stage))
+
+#else
+
+#define PROFILE_SCOPE(profiler, stage)
+
+#endif
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,120 @@
+/*
+ * RingBuffer.h
+ *
+ *    Author:
+ *     Email:
+ *
+ * Wait-free single-producer/single-consumer ring buffer. It is intended to
+ * pass data from an ISR (producer) to the background loop (consumer) or vice
+ * versa without disabling interrupts.
+ * This works because each index is written by exactly one side: the
+ * producer only writes rbHead, the consumer only writes rbTail. Aligned 32
+ * bit accesses are atomic on the Cortex-M4, and a memory barrier ensures
+ * that an item is completely written (read) before the index is updated.
+ * If the buffer is full, new items are dropped and counted.
+ * Note: As it is a template class, the whole implementation is in this
+ *       header file.
+ */
+
+#ifndef RINGBUFFER_H_
+#define RINGBUFFER_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * System.h:                Memory barrier.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "System.h"
+
+
+template <typename T, uint32_t N>
+class RingBuffer
+{
+    // Power of 2 sizes allow cheap index wrapping with a mask.
+    static_assert((N >= 2) && ((N & (N - 1)) == 0),
+                  "RingBuffer size must be a power of 2.");
+
+public:
+    inline bool push(const T &item)
+    {
+        /*
+         * Append an item. Must only be called by the producer.
+         * Returns false (and counts the item as dropped) if the buffer is
+         * full.
+         *
+         * item: The item to be copied into the buffer.
+         */
+
+        uint32_t head = rbHead;
+        if (head - rbTail >= N)
+        {
+            rbDropped++;
+            return false;
+        }
+
+        rbItems[head & (N - 1)] = item;
+
+        // The item must be complete before the consumer can see it.
+        System::memoryBarrier();
+        rbHead = head + 1;
+        return true;
+    }
+
+    inline bool pop(T &item)
+    {
+        /*
+         * Remove the oldest item. Must only be called by the consumer.
+         * Returns false if the buffer is empty.
+         *
+         * item: Reference where the item is copied to.
+         */
+
+        uint32_t tail = rbTail;
+        if (tail == rbHead)
+        {
+            return false;
+        }
+
+        // Make sure the item is read after the head index.
+        System::memoryBarrier();
+        item = rbItems[tail & (N - 1)];
+
+        // The item must be copied before the producer may overwrite it.
+        System::memoryBarrier();
+        rbTail = tail + 1;
+        return true;
+    }
+
+    inline uint32_t available()
+    {
+        /*
+         * Returns the number of items that can be popped.
+         */
+
+        return rbHead - rbTail;
+    }
+
+    inline uint32_t getDropped()
+    {
+        /*
+         * Returns the number of items dropped because the buffer was full.
+         */
+
+        return rbDropped;
+    }
+
+private:
+    /*
+     * The indices run freely and wrap at 2^32, which is a multiple of N.
+     * Therefore head - tail is always the number of stored items.
+     */
+    T rbItems[N];
+    volatile uint32_t rbHead = 0;
+    volatile uint32_t rbTail = 0;
+    volatile uint32_t rbDropped = 0;
+};
+
+#endif /* RINGBUFFER_H_ */
@@ -37,7 +37,15 @@ void Segway::init(System *sys)
     // Create private reference to the given System object.
     segwaySystem = sys;
 
-    // Initialize all objects with the given parameters and the parameters from
+    // The sensor needs some time until its gyroscope delivers valid data.
+    // Start it first, the rest of the initialization happens meanwhile (see
+    // Segway::backgroundTasks).
+    segwaySensor.init(segwaySystem,
+                      CFG_SENSOR_I2C_MODULE,
+                      CFG_SENSOR_ADRESSBIT);
+    segwaySensorStartup.set(segwaySensor.getStartupUS());
+
+    // Initialize all other objects with the given parameters and the parameters from
     // the Config header file.
     segwayLeftMotor.init(segwaySystem,
                          CFG_LM_PORT,
@@ -52,12 +60,8 @@ void Segway::init(System *sys)
                           CFG_PWM_INVERT,
                           CFG_RM_FREQ);
     segwayEnableMotors.init(segwaySystem,
-                            CFG_EM_PORT,
-                            CFG_EM_PIN,
                             CFG_EM_DIR);
     segwayFootSwitch.init(segwaySystem,
-                          CFG_FS_PORT,
-                          CFG_FS_PIN,
                           CFG_FS_DIR,
                           CFG_FS_PULLUP);
     segwayController.init(segwaySystem,
@@ -66,9 +70,13 @@ void Segway::init(System *sys)
                               CFG_BATT_BASE,
                               CFG_BATT_SSEQ,
                               CFG_BATT_AIN);
-    segwaySensor.init(segwaySystem,
-                      CFG_SENSOR_I2C_MODULE,
-                      CFG_SENSOR_ADRESSBIT);
+    if (CFG_DEEPSLEEP_MOTION_WAKE)
+    {
+        segwaySensorWake.init(segwaySystem,
+                              CFG_SENSOR_WAKE_PORT,
+                              CFG_SENSOR_WAKE_PIN,
+                              GPIO_DIR_MODE_IN);
+    }
 
     // Configure sensor orientation
     segwaySensor.setWheelAxis(CFG_SENSOR_WHEEL_AXIS);
@@ -81,9 +89,57 @@ void Segway::init(System *sys)
     // Hardware. It is not used at any other place in the code.
     segwayEnableMotors.write(CFG_EM_ACTIVE_STATE);
 
+    // In case of an error System::error switches the motors off first.
+    segwaySystem->registerSafeOutput(CFG_LM_PORT, CFG_LM_PIN1 | CFG_LM_PIN2,
+                                     CFG_PWM_INVERT ? 0xff : 0);
+    segwaySystem->registerSafeOutput(CFG_RM_PORT, CFG_RM_PIN1 | CFG_RM_PIN2,
+                                     CFG_PWM_INVERT ? 0xff : 0);
+    segwaySystem->registerSafeOutput(CFG_EM_PORT, CFG_EM_PIN,
+                                     CFG_EM_ACTIVE_STATE ? 0 : 0xff);
+
+    // The motors stay off until the segway leaves standby.
+    cutMotors();
+
     // We use floats, therefore we want to profit from the FPU.
     segwaySystem->enableFPU();
 
+    // Monitor the most important values. Note: The current tilt angle
+    // is calculated and monitored inside the Controller class.
+    segwayDebugSteering = segwaySystem->registerDebugVal("Steering_Value_[%]",
+                                                         DebugInt16);
+    segwayDebugLeft     = segwaySystem->registerDebugVal("Left_Speed_[%]",
+                                                         DebugInt16);
+    segwayDebugRight    = segwaySystem->registerDebugVal("Right_Speed_[%]",
+                                                         DebugInt16);
+    segwayDebugDropped  = segwaySystem->registerDebugVal("Dropped_Records");
+    segwayDebugResume   = segwaySystem->registerDebugVal("Resume_[us]");
+    segwayDebugWakeToBalance = segwaySystem->registerDebugVal("Wake_To_Balance_[us]");
+    segwayDebugBoot     = segwaySystem->registerDebugVal("Boot_[us]");
+    segwayDebugUpdateMax = segwaySystem->registerDebugVal("Update_Max_[cycles]");
+    segwayDebugFSEngage = segwaySystem->registerDebugVal("FS_Engage_[us]");
+    segwayDebugFSRelease = segwaySystem->registerDebugVal("FS_Release_[us]");
+
+    // Measures the duration of each stage of Segway::update (if enabled in
+    // Config.h).
+    segwayProfiler.init(segwaySystem);
+
+    // Measures CPU load and stack usage.
+    segwayMonitor.init(segwaySystem);
+
+    // Log of every control cycle
+    if (CFG_FLASHLOG_ENABLE)
+    {
+        segwayLog.init(segwaySystem, CFG_FLASHLOG_SSI, CFG_FLASHLOG_CS_PORT,
+                       CFG_FLASHLOG_CS_PIN, CFG_FLASHLOG_BITRATE,
+                       CFG_FLASHLOG_SIZE);
+    }
+
+    // Oscilloscope mode
+    if (CFG_CAPTURE_ENABLE)
+    {
+        segwayCapture.arm(CFG_CAPTURE_PRETRIGGER);
+    }
+
     // Initializing done, segway is ready but not active yet.
     segwayStandby = true;
 }
@@ -95,23 +151,61 @@ void Segway::update()
      * resulting motor duty cycles.
      */
 
-    // Get state of the foot switch.
-    bool footSwitchPressed = (segwayFootSwitch.read() == CFG_FS_ACTIVE_STATE);
+    PROFILE_SCOPE(segwayProfiler, ProfUpdate);
+
+    // Record of this control cycle for the background loop. Everything not
+    // measured in this cycle stays 0.
+    uint32_t start = CycleCounter::get();
+    uint64_t now = TimeBase::getUS();
+    SegwayRecord record = {};
+    record.timestamp = now;
+    record.cycle = segwayCycle++;
+
+    // Boot time: reset to the first control cycle.
+    if (record.cycle == 0)
+    {
+        segwaySystem->markBoot(BootFirstCycle);
+    }
+
+    // Get state of the foot switch: debounced by its ISRs if enabled (see
+    // Segway::enableFootSwitchInt), polled otherwise.
+    bool footSwitchPressed;
+    {
+        PROFILE_SCOPE(segwayProfiler, ProfFootSwitch);
+        footSwitchPressed = segwayFSIntEnabled
+                            ? segwayFSPressed
+                            : (segwayFootSwitch.read() == CFG_FS_ACTIVE_STATE);
+    }
+    record.footSwitch = footSwitchPressed;
 
     /*
      * Standby Mode controls whether the segway runs or not. The segway leaves
      * standby when the food switch is pressed and returns to standby if it's
-     * released.
-     * This is the polling variant, the other variant would be rising and
-     * falling edge interrupts, which would be more complicated.
+     * released. With the foot switch interrupts the motors are already
+     * stopped by Segway::footSwitchDebounceISR when the foot switch is
+     * released; this only follows.
      */
     if (segwayStandby == true)
     {
-        if (footSwitchPressed)
+        // The sensor is not ready during and right after the deep-sleep.
+        if (footSwitchPressed && segwaySensorReady && releaseMotors())
         {
             // Someone stepped on the segway, so we can leave standby and
             // start driving.
             segwayStandby = false;
+            segwayWakeTimestamp = now;
+            BlackBox::event(BBoxStandbyLeave);
+            if (segwayFSIntEnabled)
+            {
+                segwayFSEngageUS = TimeBase::getUS() - segwayFSPressEdgeUS;
+            }
+
+            // First ride after the deep-sleep.
+            if (segwayResumed)
+            {
+                segwayResumed = false;
+                segwayWakeToBalanceUS = TimeBase::getUS() - segwayResumeTimestamp;
+            }
         }
     }
     else
@@ -123,30 +217,62 @@ void Segway::update()
 
             // Variables for debugging purpose only
 
-            float steeringValue = segwaySteering.getValue();
+            float steeringValue;
+            {
+                PROFILE_SCOPE(segwayProfiler, ProfSteering);
+                steeringValue = segwaySteering.getValue();
+            }
 
             // Get current angle rate in rad from the gyro
-            float angleRateRad = segwaySensor.getAngleRate() * 3.14159265358979f / 180.0f;
+            float angleRateRad;
+            {
+                PROFILE_SCOPE(segwayProfiler, ProfMPUAngleRate);
+                angleRateRad = segwaySensor.getAngleRate() * 3.14159265358979f / 180.0f;
+            }
 
             // Get current accelerations in g from the accelerometer
-            float accelHor = segwaySensor.getAccelHor();
-            float accelVer = segwaySensor.getAccelVer();
+            float accelHor, accelVer;
+            {
+                PROFILE_SCOPE(segwayProfiler, ProfMPUAccelHor);
+                accelHor = segwaySensor.getAccelHor();
+            }
+            {
+                PROFILE_SCOPE(segwayProfiler, ProfMPUAccelVer);
+                accelVer = segwaySensor.getAccelVer();
+            }
 
             // Feed the new sensor data into the controller
-            segwayController.updateValuesRad(steeringValue, angleRateRad, accelHor, accelVer);
+            {
+                PROFILE_SCOPE(segwayProfiler, ProfController);
+                segwayController.updateValuesRad(steeringValue, angleRateRad, accelHor, accelVer);
+            }
 
             float leftMotorDuty = segwayController.getLeftSpeed();
             float rightMotorDuty = segwayController.getRightSpeed();
 
             // Apply the new duty cycles to the motors
-            segwayLeftMotor.setDuty(leftMotorDuty);
-            segwayRightMotor.setDuty(rightMotorDuty);
-
-            // Monitor the most important values. Note: The current tilt angle
-            // is calculated and monitored inside the Controller class.
-            segwaySystem->setDebugVal("Steering_Value_[%]", steeringValue * 100);
-            segwaySystem->setDebugVal("Left_Speed_[%]" , leftMotorDuty * 100);
-            segwaySystem->setDebugVal("Right_Speed_[%]" , rightMotorDuty * 100);
+            {
+                PROFILE_SCOPE(segwayProfiler, ProfPWM);
+                segwayLeftMotor.setDuty(leftMotorDuty);
+                segwayRightMotor.setDuty(rightMotorDuty);
+            }
+
+            record.steering   = steeringValue;
+            record.angleRate  = angleRateRad;
+            record.accelHor   = accelHor;
+            record.accelVer   = accelVer;
+            record.angle      = segwayController.getAngleRad();
+            record.driveSpeed = segwayController.getDriveSpeed();
+            record.leftDuty   = leftMotorDuty;
+            record.rightDuty  = rightMotorDuty;
+
+            // Monitor the most important values.
+            {
+                PROFILE_SCOPE(segwayProfiler, ProfDebugVals);
+                segwaySystem->setDebugVal(segwayDebugSteering, steeringValue * 100);
+                segwaySystem->setDebugVal(segwayDebugLeft, leftMotorDuty * 100);
+                segwaySystem->setDebugVal(segwayDebugRight, rightMotorDuty * 100);
+            }
         }
         else
         {
@@ -155,16 +281,61 @@ void Segway::update()
 
             // Stop the motors and reset all speeds to 0 as the segway is not
             // moving in standby.
+            cutMotors();
             segwayController.resetSpeeds();
             segwayLeftMotor.setDuty(0);
             segwayRightMotor.setDuty(0);
 
             segwayStandby = true;
+            BlackBox::event(BBoxStandbyEnter);
+
+            // The ride is over; a good moment to look at the timings.
+            segwayProfiler.requestReport();
         }
     }
 
-    // Successfully passed the update method.
-    segwayUpdateFlag = true;
+    // CPU load, stack usage and lost records are always monitored.
+    segwayMonitor.publish();
+    segwaySystem->setDebugVal(segwayDebugDropped, segwayRecords.getDropped());
+    segwaySystem->setDebugVal(segwayDebugResume, segwayResumeUS);
+    segwaySystem->setDebugVal(segwayDebugWakeToBalance, segwayWakeToBalanceUS);
+    segwaySystem->setDebugVal(segwayDebugBoot,
+                              segwaySystem->getBootUS(BootFirstCycle));
+    segwaySystem->setDebugVal(segwayDebugUpdateMax, segwayMaxUpdateDuration);
+    segwaySystem->setDebugVal(segwayDebugFSEngage, segwayFSEngageUS);
+    segwaySystem->setDebugVal(segwayDebugFSRelease, segwayFSReleaseUS);
+
+    // Successfully passed the update method. Hand the record to the
+    // background loop.
+    record.standby = segwayStandby;
+
+    // Capture triggers
+    if ((CFG_CAPTURE_TRIG_ANGLE > 0.0f)
+        && (fabsf(record.angle) > CFG_CAPTURE_TRIG_ANGLE))
+    {
+        record.triggers |= SEGWAY_TRIG_ANGLE;
+    }
+    if (CFG_CAPTURE_TRIG_FOOTSWITCH
+        && (footSwitchPressed != segwayLastFootSwitch))
+    {
+        record.triggers |= SEGWAY_TRIG_FOOTSWITCH;
+    }
+    if (CFG_CAPTURE_TRIG_SATURATION
+        && ((fabsf(record.leftDuty) >= CFG_CTLR_MAXDUTY)
+            || (fabsf(record.rightDuty) >= CFG_CTLR_MAXDUTY)))
+    {
+        record.triggers |= SEGWAY_TRIG_SATURATION;
+    }
+    segwayLastFootSwitch = footSwitchPressed;
+
+    // Flight recorder: angle in mrad, steering and duty cycles in per mille.
+    BlackBox::record(record.cycle, record.angle * 1000.0f,
+                     record.steering * 1000.0f, record.leftDuty * 1000.0f,
+                     record.rightDuty * 1000.0f);
+
+    record.duration = CycleCounter::get() - start;
+    segwayRecords.push(record);
+    segwayCapture.record(record, record.triggers);
 }
 
 void Segway::backgroundTasks()
@@ -173,11 +344,549 @@ void Segway::backgroundTasks()
      * While the Segway::update() method runs the time-critical controller
      * related code, this method can run in background for monitoring tasks.
      * Some tasks need to sync with the ISR/Segway::update method. That's what
-     * the segwayUpdateFlag is for.
+     * the records in segwayRecords are for: one per control cycle.
+     * Note: This method must be called as often as possible (it is the
+     *       "idle task") because it measures the CPU load, too.
+     */
+
+    segwayMonitor.idle();
+
+    /*
+     * The sensor started up (after the boot or the deep-sleep): the
+     * controller starts with the current tilt angle and the control ISR may
+     * leave standby. Polled instead of waiting, so that the rest of the
+     * initialization and the control cycles are not delayed.
+     */
+    if (!segwaySensorReady && segwaySensorStartup.expired())
+    {
+        uint32_t state = segwaySystem->enterCritical();
+        segwayController.resetAngle(segwaySensor.getAccelHor(),
+                                    segwaySensor.getAccelVer());
+        if (segwayResumed)
+        {
+            segwayResumeUS = TimeBase::getUS() - segwayResumeTimestamp;
+        }
+        segwaySensorReady = true;
+        segwaySystem->exitCritical(state);
+    }
+
+    // Process all control cycles since the last call.
+    SegwayRecord record;
+    while (segwayRecords.pop(record))
+    {
+        if (record.duration > segwayMaxUpdateDuration)
+        {
+            segwayMaxUpdateDuration = record.duration;
+        }
+        if (CFG_FLASHLOG_ENABLE)
+        {
+            logRecord(record);
+        }
+
+        // Running for a while without an error: a restart after an error
+        // (see System::error) succeeded. Errors which come back earlier
+        // count as consecutive restarts.
+        if (record.cycle == CFG_SYS_STABLE_TIME * CFG_CTLR_UPDATE_FREQ)
+        {
+            BlackBox::clearRestarts();
+        }
+
+        segwayStandbyCycles = record.standby ? segwayStandbyCycles + 1 : 0;
+    }
+
+    // All boot phases are complete once the first record arrived.
+    if (!segwayBootReported && segwayCycle)
+    {
+        segwayBootReported = true;
+        segwaySystem->reportBoot();
+    }
+
+    // Parked for a long time: save the battery.
+    if (CFG_DEEPSLEEP_TIMEOUT
+        && (segwayStandbyCycles >= CFG_DEEPSLEEP_TIMEOUT * CFG_CTLR_UPDATE_FREQ))
+    {
+        deepSleep();
+        segwayStandbyCycles = 0;
+    }
+
+    // Program the logged records into the flash.
+    segwayLog.process();
+
+    // Transmit the profiler statistics if requested.
+    if (segwayProfiler.reportRequested())
+    {
+        segwayProfiler.sendReport();
+    }
+
+    // Transmit a complete capture, a few lines per iteration.
+    if ((segwayCapture.getState() == CaptureComplete) && dumpCapture())
+    {
+        segwayCapture.release();
+        if (CFG_CAPTURE_REARM)
+        {
+            segwayCapture.arm(CFG_CAPTURE_PRETRIGGER);
+        }
+    }
+
+    // Nothing left to do: sleep until the next interrupt. The flash log
+    // polls the flash, so it must not wait for an interrupt.
+    if (CFG_SYS_IDLE_SLEEP && segwayLog.isIdle())
+    {
+        segwayMonitor.sleep();
+    }
+}
+
+uint32_t Segway::getDroppedRecords()
+{
+    /*
+     * Returns the number of control cycle records which have been lost
+     * because the background loop did not process them in time.
+     */
+
+    return segwayRecords.getDropped();
+}
+
+uint32_t Segway::getMaxUpdateDuration()
+{
+    /*
+     * Returns the maximum duration of Segway::update in CPU cycles, as seen
+     * by the background loop.
+     */
+
+    return segwayMaxUpdateDuration;
+}
+
+bool Segway::isStandby()
+{
+    /*
+     * Returns true while nobody stands on the segway (motors off).
+     */
+
+    return segwayStandby;
+}
+
+uint64_t Segway::getWakeTimestamp()
+{
+    /*
+     * Returns the start of the control cycle which left the standby most
+     * recently, in microseconds since the reset (see TimeBase::getUS).
+     */
+
+    return segwayWakeTimestamp;
+}
+
+void Segway::updateClock()
+{
+    /*
+     * Adapt all peripherals of the segway to a new CPU clock (see
+     * System::setClockFreq). The ADCs use their own clock. Call it from the
+     * background loop right after the clock change, inside the critical
+     * section returned by System::setClockFreq.
+     */
+
+    uint32_t state = segwaySystem->enterCritical();
+    segwayLeftMotor.setFreq(CFG_LM_FREQ);
+    segwayRightMotor.setFreq(CFG_RM_FREQ);
+    segwaySensor.updateClock();
+    segwaySystem->exitCritical(state);
+
+    // A running debounce timeout still counts the cycles of the old clock.
+    // It is restarted with the full debounce time, which only delays the
+    // foot switch once per clock change. The foot switch ISRs can not be
+    // masked by System::enterCritical.
+    if (segwayFSIntEnabled)
+    {
+        bool disabled = IntMasterDisable();
+        if (segwayFSBouncing)
+        {
+            bool pressed = (segwayFootSwitch.read() == CFG_FS_ACTIVE_STATE);
+            segwayFSDebounce.restartUS(pressed ? CFG_FS_PRESS_DEBOUNCE_US
+                                               : CFG_FS_RELEASE_DEBOUNCE_US);
+        }
+        if (!disabled)
+        {
+            IntMasterEnable();
+        }
+    }
+
+    segwayLog.updateClock();
+}
+
+void Segway::deepSleep()
+{
+    /*
+     * Power down everything until someone steps on the foot switch or (if
+     * enabled) moves the segway: the motor driver is disabled, the MPU6050
+     * sleeps and the uC enters deep-sleep (see System::deepSleep).
+     * Everything in RAM (calibration, configuration, controller) is kept.
+     * Afterwards the sensor is woken up; once it delivers valid data the
+     * controller restarts with the current tilt angle (see
+     * Segway::backgroundTasks), so balancing can start as early as possible.
+     * The time until then is published as Resume_[us], the time until the
+     * first controller cycle as Wake_To_Balance_[us].
+     * Note: Only call it from the background loop.
+     */
+
+    // Someone may have just stepped on the segway.
+    uint32_t state = segwaySystem->enterCritical();
+    if (!segwayStandby)
+    {
+        segwaySystem->exitCritical(state);
+        return;
+    }
+    segwaySensorReady = false;
+    BlackBox::event(BBoxSleep);
+    segwaySystem->exitCritical(state);
+
+    // Flush the logged records.
+    while (!segwayLog.isIdle())
+    {
+        segwayLog.process();
+    }
+
+    segwayEnableMotors.write(!CFG_EM_ACTIVE_STATE);
+    segwaySensor.sleep(CFG_DEEPSLEEP_MOTION_WAKE,
+                       CFG_DEEPSLEEP_MOTION_THRESHOLD);
+
+    // Wake-up sources: pressing the foot switch and the INT pin of the
+    // sensor going high. The edge interrupt of the foot switch may already
+    // be enabled; then its ISR handles the wake-up edge afterwards.
+    if (!segwayFSIntEnabled)
+    {
+        uint32_t fsEdge = CFG_FS_ACTIVE_STATE ? GPIO_RISING_EDGE
+                                              : GPIO_FALLING_EDGE;
+        GPIOIntTypeSet(CFG_FS_PORT, CFG_FS_PIN, fsEdge);
+        GPIOIntClear(CFG_FS_PORT, CFG_FS_PIN);
+        GPIOIntEnable(CFG_FS_PORT, CFG_FS_PIN);
+    }
+    SysCtlPeripheralDeepSleepEnable(segwaySystem->getGPIOPeriph(CFG_FS_PORT));
+    uint32_t sensorInt = 0;
+    if (CFG_DEEPSLEEP_MOTION_WAKE)
+    {
+        GPIOIntTypeSet(CFG_SENSOR_WAKE_PORT, CFG_SENSOR_WAKE_PIN,
+                       GPIO_RISING_EDGE);
+        GPIOIntClear(CFG_SENSOR_WAKE_PORT, CFG_SENSOR_WAKE_PIN);
+        GPIOIntEnable(CFG_SENSOR_WAKE_PORT, CFG_SENSOR_WAKE_PIN);
+        SysCtlPeripheralDeepSleepEnable(
+                segwaySystem->getGPIOPeriph(CFG_SENSOR_WAKE_PORT));
+        sensorInt = CFG_SENSOR_WAKE_INT;
+    }
+
+    segwaySystem->deepSleep(CFG_FS_INT, sensorInt);
+    segwayResumeTimestamp = TimeBase::getUS();
+
+    if (!segwayFSIntEnabled)
+    {
+        GPIOIntDisable(CFG_FS_PORT, CFG_FS_PIN);
+        GPIOIntClear(CFG_FS_PORT, CFG_FS_PIN);
+    }
+    if (CFG_DEEPSLEEP_MOTION_WAKE)
+    {
+        GPIOIntDisable(CFG_SENSOR_WAKE_PORT, CFG_SENSOR_WAKE_PIN);
+        GPIOIntClear(CFG_SENSOR_WAKE_PORT, CFG_SENSOR_WAKE_PIN);
+    }
+    state = segwaySystem->enterCritical();
+    BlackBox::event(BBoxWake, segwayFootSwitch.read() == CFG_FS_ACTIVE_STATE);
+    segwaySystem->exitCritical(state);
+
+    // Restore the sensor. The control ISR stays in standby until the sensor
+    // is ready.
+    segwaySensor.wake();
+    segwaySensorStartup.set(segwaySensor.getStartupUS());
+    segwayEnableMotors.write(CFG_EM_ACTIVE_STATE);
+    segwayResumed = true;
+}
+
+void Segway::enableFootSwitchInt(void (*edgeISR)(void))
+{
+    /*
+     * Debounce the foot switch with interrupts instead of polling it once per
+     * control cycle. Each edge (re)starts a one-shot timer; when it expires
+     * the foot switch has been stable for CFG_FS_PRESS_DEBOUNCE_US
+     * (pressed) or CFG_FS_RELEASE_DEBOUNCE_US (released). A confirmed release
+     * stops the motors right away, independent of the control cycle. The
+     * latencies from the first edge until the motors stop or until the first
+     * control cycle driving them are published as FS_Release_[us] and
+     * FS_Engage_[us].
+     * The ISRs should have the priority CFG_PRIO_FOOTSWITCH (see
+     * System::setIntPriority). Call it after Segway::init.
+     * Note: The debounce timer calls Segway::footSwitchDebounceISR
+     *       directly (see Delegate.h). The GPIO port needs an ISR function,
+     *       therefore the caller provides a helper function calling
+     *       Segway::footSwitchISR.
+     *
+     * edgeISR: ISR of the GPIO port of the foot switch.
+     */
+
+    segwayFSDebounce.init(segwaySystem, CFG_FS_DEBOUNCE_TIMER_BASE,
+                          Delegate::bind<Segway,
+                                         &Segway::footSwitchDebounceISR>(this),
+                          0, TimerOneShot);
+
+    segwayFSPressed = (segwayFootSwitch.read() == CFG_FS_ACTIVE_STATE);
+    segwayFSIntEnabled = true;
+
+    GPIOIntRegister(CFG_FS_PORT, edgeISR);
+    GPIOIntTypeSet(CFG_FS_PORT, CFG_FS_PIN, GPIO_BOTH_EDGES);
+    GPIOIntClear(CFG_FS_PORT, CFG_FS_PIN);
+    GPIOIntEnable(CFG_FS_PORT, CFG_FS_PIN);
+}
+
+void Segway::footSwitchISR()
+{
+    /*
+     * Edge of the foot switch (see Segway::enableFootSwitchInt): restart the
+     * debounce timer with the time the new state must be stable.
+     */
+
+    // Other pins of the port (f.ex. the sensor wake-up) are cleared, too.
+    uint32_t status = GPIOIntStatus(CFG_FS_PORT, true);
+    GPIOIntClear(CFG_FS_PORT, status);
+    if (!(status & CFG_FS_PIN))
+    {
+        return;
+    }
+
+    if (!segwayFSBouncing)
+    {
+        segwayFSEdgeUS = TimeBase::getUS();
+        segwayFSBouncing = true;
+    }
+
+    bool pressed = (segwayFootSwitch.read() == CFG_FS_ACTIVE_STATE);
+    segwayFSDebounce.restartUS(pressed ? CFG_FS_PRESS_DEBOUNCE_US
+                                       : CFG_FS_RELEASE_DEBOUNCE_US);
+}
+
+void Segway::footSwitchDebounceISR()
+{
+    /*
+     * The foot switch has been stable since the last edge. A release stops
+     * the motors at once; the control ISR enters standby in its next cycle.
+     * A press is only taken over by the next control cycle. Called by the
+     * debounce timer, which clears its interrupt flag.
      */
 
-    if (segwayUpdateFlag)
+    segwayFSBouncing = false;
+
+    bool pressed = (segwayFootSwitch.read() == CFG_FS_ACTIVE_STATE);
+    if (pressed == segwayFSPressed)
+    {
+        // Only bounced.
+        return;
+    }
+
+    if (pressed)
+    {
+        segwayFSPressEdgeUS = segwayFSEdgeUS;
+    }
+    else
+    {
+        cutMotors();
+        segwayFSReleaseUS = TimeBase::getUS() - segwayFSEdgeUS;
+    }
+    segwayFSPressed = pressed;
+}
+
+void Segway::cutMotors()
+{
+    /*
+     * Stop both motors by driving their pins with the inactive level, taking
+     * them over from the PWM generators (like System::error). Takes a few
+     * register writes, independent of the PWM state.
+     */
+
+    segwayLeftMotorPins.takeOver(CFG_PWM_INVERT ? 0xff : 0);
+    segwayRightMotorPins.takeOver(CFG_PWM_INVERT ? 0xff : 0);
+}
+
+bool Segway::releaseMotors()
+{
+    /*
+     * Hand the motor pins back to the PWM generators when leaving standby.
+     * Returns false (and keeps the motors stopped) if the foot switch ISR has
+     * confirmed a release meanwhile.
+     */
+
+    // The foot switch ISRs can not be masked by System::enterCritical.
+    bool disabled = IntMasterDisable();
+    bool pressed = !segwayFSIntEnabled || segwayFSPressed;
+    if (pressed)
+    {
+        segwayLeftMotorPins.release();
+        segwayRightMotorPins.release();
+    }
+    if (!disabled)
+    {
+        IntMasterEnable();
+    }
+    return pressed;
+}
+
+bool Segway::dumpCapture()
+{
+    /*
+     * Send a complete capture via the debug UART, at most
+     * CFG_CAPTURE_DUMP_LINES lines per call and only as many as fit into the
+     * transmit queue (see System::getDebugTxSpace), so the background loop
+     * keeps processing the records and the flash log meanwhile. Returns true
+     * once the whole capture has been queued.
+     * Transmission format (one line per control cycle, tab separated):
+     *   CAP\tIndex\tTime_[us]\tCycle\tDuration_[cycles]\tTriggers\t
+     *   Standby\tFootSwitch\tSteering\tAngleRate_[rad/s]\tAccelHor_[g]\t
+     *   AccelVer_[g]\tAngle_[rad]\tDriveSpeed\tLeftDuty\tRightDuty
+     * Index and time are relative to the trigger cycle. Triggers is a
+     * combination of SEGWAY_TRIG_... .
+     * Note: Periodic debug values are paused until the last line is queued
+     *       so that the lines do not get mixed up. Do not call it from an
+     *       ISR. Only sent with the DebugText format (see
+     *       System::getDebugFormat).
+     */
+
+    if (segwaySystem->getDebugFormat() != DebugText)
+    {
+        return true;
+    }
+
+    const char header[] = "CAP\tIndex\tTime_[us]\tCycle\tDuration_[cycles]"
+                          "\tTriggers\tStandby\tFootSwitch\tSteering"
+                          "\tAngleRate_[rad/s]\tAccelHor_[g]\tAccelVer_[g]"
+                          "\tAngle_[rad]\tDriveSpeed\tLeftDuty\tRightDuty";
+    const uint32_t decimals = 4;
+
+    if (!segwayCaptureDumping)
+    {
+        segwayCaptureDumping = true;
+        segwayCaptureRendered = false;
+        segwayCaptureLine = 0;
+        segwayCaptureDebugging = segwaySystem->getDebugging();
+        segwaySystem->setDebugging(false);
+    }
+
+    uint32_t triggerIndex = segwayCapture.getTriggerIndex();
+    uint32_t triggerTime = segwayCapture.get(triggerIndex).timestamp;
+    for (uint_fast8_t n = 0; n < CFG_CAPTURE_DUMP_LINES; n++)
+    {
+        if (segwayCaptureLine > segwayCapture.getSize())
+        {
+            break;
+        }
+
+        // A line which did not fit is kept for the next call.
+        if (!segwayCaptureRendered)
+        {
+            segwayCaptureText.begin();
+            if (segwayCaptureLine == 0)
+            {
+                segwayCaptureText.putString(header);
+            }
+            else
+            {
+                uint32_t i = segwayCaptureLine - 1;
+                const SegwayRecord &record = segwayCapture.get(i);
+
+                segwayCaptureText.putString("CAP\t");
+                segwayCaptureText.putInt(i - triggerIndex);
+                segwayCaptureText.putChar('\t');
+                segwayCaptureText.putInt((int32_t) (record.timestamp
+                                                    - triggerTime));
+                segwayCaptureText.putChar('\t');
+                segwayCaptureText.putInt(record.cycle);
+                segwayCaptureText.putChar('\t');
+                segwayCaptureText.putInt(record.duration);
+                segwayCaptureText.putChar('\t');
+                segwayCaptureText.putInt(record.triggers);
+                segwayCaptureText.putChar('\t');
+                segwayCaptureText.putInt(record.standby);
+                segwayCaptureText.putChar('\t');
+                segwayCaptureText.putInt(record.footSwitch);
+                const float values[] = {record.steering, record.angleRate,
+                                        record.accelHor, record.accelVer,
+                                        record.angle, record.driveSpeed,
+                                        record.leftDuty, record.rightDuty};
+                for (uint_fast8_t j = 0;
+                     j < sizeof(values) / sizeof(values[0]); j++)
+                {
+                    segwayCaptureText.putChar('\t');
+                    segwayCaptureText.putFixed(values[j], decimals);
+                }
+            }
+            segwayCaptureText.endLine();
+            segwayCaptureRendered = true;
+        }
+
+        if (segwaySystem->getDebugTxSpace() < segwayCaptureText.getLength())
+        {
+            break;
+        }
+        segwaySystem->queueDebugTx(segwayCaptureText.getData(),
+                                   segwayCaptureText.getLength());
+        segwayCaptureRendered = false;
+        segwayCaptureLine++;
+    }
+
+    if (segwayCaptureLine <= segwayCapture.getSize())
+    {
+        return false;
+    }
+
+    segwayCaptureDumping = false;
+    segwaySystem->setDebugging(segwayCaptureDebugging);
+    return true;
+}
+
+void Segway::logRecord(const SegwayRecord &record)
+{
+    /*
+     * Append a control cycle record to the flash log. Frame layout (type
+     * TELEMETRY_FRAME_RECORD, see TelemetryFrame.h and Tools/flashlog_read.py):
+     *   uint16_t cycle (lowest 16 bits)
+     *   uint32_t timestamp [us since the reset, lowest 32 bits]
+     *   uint16_t duration of Segway::update [CPU cycles], saturated
+     *   uint8_t  flags: standby (bit 0), foot switch (bit 1), triggers
+     *            (bits 2-4, SEGWAY_TRIG_...)
+     *   int16_t  steering, angle rate, acceleration hor./ver., angle, drive
+     *            speed, left and right duty cycle, all in 1/1000 of their
+     *            unit (f.ex. mrad), saturated
+     * A ride ends with standby, that's when the partially filled page is
+     * written, too.
+     */
+
+    segwayLogFrame.begin(TELEMETRY_FRAME_RECORD);
+    segwayLogFrame.putU16(record.cycle);
+    segwayLogFrame.putU32(record.timestamp);
+    segwayLogFrame.putU16(record.duration > 0xffff ? 0xffff : record.duration);
+    segwayLogFrame.putU8(record.standby | (record.footSwitch << 1)
+                         | (record.triggers << 2));
+
+    const float values[] = {record.steering, record.angleRate,
+                            record.accelHor, record.accelVer,
+                            record.angle, record.driveSpeed,
+                            record.leftDuty, record.rightDuty};
+    for (uint_fast8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        // Rounded to the nearest integer.
+        float scaled = values[i] * 1000.0f;
+        scaled += (scaled < 0.0f) ? -0.5f : 0.5f;
+        if (scaled > 32767.0f)
+        {
+            scaled = 32767.0f;
+        }
+        else if (scaled < -32768.0f)
+        {
+            scaled = -32768.0f;
+        }
+        segwayLogFrame.putU16((int16_t) scaled);
+    }
+
+    if (segwayLogFrame.finish())
+    {
+        segwayLog.append(segwayLogFrame.getData(), segwayLogFrame.getLength());
+    }
+
+    if (record.standby && !segwayLogStandby)
     {
-        segwayUpdateFlag = false;
+        segwayLog.flush();
     }
+    segwayLogStandby = record.standby;
 }
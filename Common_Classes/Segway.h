@@ -21,10 +21,20 @@
  * Controller.h: Header file for the Controller class containing the control
  *               algorithm to drive a segway.
  * GPIO.h:       Header file for the GPIO class
+ * Pin.h:        GPIO pins known at compile time (single load/store access).
+ * Timer.h:      One-shot timer of the foot switch debouncing.
  * PWM.h:        Header file for the PWM class
  * ADC.h:        Header file for the ADC class
  * MPU6050.h:    Header file for the MPU6050 class
  * Steering.h:   Header file for the Steering class
+ * Profiler.h:   Header file for the Profiler class (cycle measurements)
+ * Monitor.h:    Header file for the Monitor class (CPU load and stack usage)
+ * RingBuffer.h: Lock-free buffer to pass data from the ISR to the background
+ *               loop.
+ * Capture.h:    Triggered capture buffer (oscilloscope mode).
+ * BlackBox.h:   Crash-persistent record of the last control cycles.
+ * FlashLog.h:   Log of every control cycle on an external flash.
+ * math.h:       fabsf for the capture triggers.
  */
 #include <stdbool.h>
 #include <stdint.h>
@@ -32,34 +42,139 @@
 #include "System.h"
 #include "Controller.h"
 #include "GPIO.h"
+#include "Pin.h"
+#include "Timer.h"
 #include "PWM.h"
 #include "ADC.h"
 #include "MPU6050.h"
 #include "Steering.h"
+#include "Profiler.h"
+#include "Monitor.h"
+#include "RingBuffer.h"
+#include "Capture.h"
+#include "BlackBox.h"
+#include "FlashLog.h"
+#include <math.h>
+
+struct SegwayRecord
+{
+    /*
+     * Everything that happened in one control cycle. Passed from
+     * Segway::update to Segway::backgroundTasks and recorded by the capture
+     * buffer.
+     */
+    uint32_t cycle;             // Number of the control cycle
+    uint32_t timestamp;         // Start of the cycle [us since the reset]
+    uint32_t duration;          // Duration of Segway::update [cycles]
+    bool standby;
+    bool footSwitch;
+    uint8_t triggers;           // Capture triggers met (SEGWAY_TRIG_...)
+    float steering;             // Sample
+    float angleRate;            // [rad/s]
+    float accelHor, accelVer;   // [g]
+    float angle;                // Estimated tilt angle [rad]
+    float driveSpeed;           // Estimated drive speed
+    float leftDuty, rightDuty;  // Outputs
+};
+
+// Capture triggers (see SegwayRecord::triggers)
+#define SEGWAY_TRIG_ANGLE           0x01
+#define SEGWAY_TRIG_FOOTSWITCH      0x02
+#define SEGWAY_TRIG_SATURATION      0x04
 
 class Segway
 {
 public:
     Segway();
-    virtual ~Segway();
+    ~Segway();
     void init(System *sys);
-    void update();
+    RAMFUNC void update();
     void backgroundTasks();
+    uint32_t getDroppedRecords();
+    uint32_t getMaxUpdateDuration();
+    bool isStandby();
+    uint64_t getWakeTimestamp();
+    void updateClock();
+    void enableFootSwitchInt(void (*edgeISR)(void));
+    void footSwitchISR();
+    void footSwitchDebounceISR();
 
 private:
+    void cutMotors();
+    bool releaseMotors();
+    bool dumpCapture();
+    void deepSleep();
+    void logRecord(const SegwayRecord &record);
+
     System* segwaySystem;
+    DebugHandle segwayDebugSteering, segwayDebugLeft, segwayDebugRight,
+                segwayDebugDropped, segwayDebugResume, segwayDebugWakeToBalance,
+                segwayDebugBoot, segwayDebugUpdateMax, segwayDebugFSEngage,
+                segwayDebugFSRelease;
 
     Controller segwayController;
-    GPIO segwayFootSwitch, segwayEnableMotors;
+    GPIO segwaySensorWake;
+
+    // Accessed in every control cycle, therefore compile-time pins.
+    Pin<CFG_FS_PORT, CFG_FS_PIN> segwayFootSwitch;
+    Pin<CFG_EM_PORT, CFG_EM_PIN> segwayEnableMotors;
+    Pin<CFG_LM_PORT, CFG_LM_PIN1 | CFG_LM_PIN2> segwayLeftMotorPins;
+    Pin<CFG_RM_PORT, CFG_RM_PIN1 | CFG_RM_PIN2> segwayRightMotorPins;
     Steering segwaySteering;
     PWM segwayLeftMotor, segwayRightMotor;
     ADC segwayBatteryVoltage;
     MPU6050 segwaySensor;
+    Profiler segwayProfiler;
+    Monitor segwayMonitor;
 
-    // Flags
-    bool segwayUpdateFlag = false;
+    // Records of the control cycles, passed from the ISR to the background.
+    RingBuffer<SegwayRecord, CFG_SEGWAY_RECORD_BUFFER> segwayRecords;
+    uint32_t segwayCycle = 0;
+    uint32_t segwayMaxUpdateDuration = 0;
+
+    // Oscilloscope mode: every control cycle, dumped after a trigger. The
+    // dump is spread over several background loop iterations: next line
+    // (0 is the header), whether it is already rendered into
+    // segwayCaptureText and the debugging state to restore afterwards.
+    Capture<SegwayRecord, CFG_CAPTURE_SIZE> segwayCapture;
+    TelemetryText segwayCaptureText;
+    bool segwayLastFootSwitch = false;
+    bool segwayCaptureDumping = false, segwayCaptureRendered = false;
+    bool segwayCaptureDebugging = false;
+    uint32_t segwayCaptureLine = 0;
+
+    // Every control cycle on the external flash.
+    FlashLog segwayLog;
+    TelemetryFrame segwayLogFrame;
+    bool segwayLogStandby = true;
 
     bool segwayStandby = true;
+    uint64_t segwayWakeTimestamp = 0;
+
+    // Debounced foot switch (see Segway::enableFootSwitchInt). Written by its
+    // ISRs only. Times in microseconds (TimeBase): first edge of the current
+    // bouncing, first edge of the last press and the latencies.
+    bool segwayFSIntEnabled = false;
+    Timer segwayFSDebounce;
+    volatile bool segwayFSPressed = false, segwayFSBouncing = false;
+    volatile uint64_t segwayFSEdgeUS = 0, segwayFSPressEdgeUS = 0;
+    volatile uint32_t segwayFSReleaseUS = 0;
+    uint32_t segwayFSEngageUS = 0;
+
+    // Sensor start-up after the boot and the deep-sleep.
+    volatile bool segwaySensorReady = false;
+    Deadline segwaySensorStartup;
+
+    // Deep-sleep: control cycles in standby and the times from the wake-up
+    // to the sensor being ready and to balancing [us]. Measured with the
+    // time base, as the cycle counter stops while sleeping.
+    uint32_t segwayStandbyCycles = 0;
+    bool segwayResumed = false;
+    uint64_t segwayResumeTimestamp = 0;
+    uint32_t segwayResumeUS = 0, segwayWakeToBalanceUS = 0;
+
+    // Boot timing sent once (see System::reportBoot).
+    bool segwayBootReported = false;
 };
 
 #endif /* SEGWAY_H_ */
@@ -10,6 +10,82 @@
 #include <System.h>
 
 
+// The TI compiler accepts the GCC attribute when --gcc is set.
+uint8_t System::systemDMAControlTable[1024] __attribute__((aligned(1024)));
+
+System::DebugSnapshot System::systemDebugSnapshot;
+TelemetryText System::systemDebugText;
+TelemetryFrame System::systemDebugFrame;
+uint8_t System::systemTxBuffers[2][systemTxBufferSize];
+System *System::systemActive = 0;
+
+// Storage of the static table (values in System.h), in the flash.
+constexpr uint32_t System::systemGPIOPorts[6][2];
+
+const uint32_t System::systemPeripherals[49] = {SYSCTL_PERIPH_WDOG0,
+                                                SYSCTL_PERIPH_WDOG1,
+                                                SYSCTL_PERIPH_TIMER0,
+                                                SYSCTL_PERIPH_TIMER1,
+                                                SYSCTL_PERIPH_TIMER2,
+                                                SYSCTL_PERIPH_TIMER3,
+                                                SYSCTL_PERIPH_TIMER4,
+                                                SYSCTL_PERIPH_TIMER5,
+                                                SYSCTL_PERIPH_GPIOA,
+                                                SYSCTL_PERIPH_GPIOB,
+                                                SYSCTL_PERIPH_GPIOC,
+                                                SYSCTL_PERIPH_GPIOD,
+                                                SYSCTL_PERIPH_GPIOE,
+                                                SYSCTL_PERIPH_GPIOF,
+                                                SYSCTL_PERIPH_UDMA,
+                                                SYSCTL_PERIPH_HIBERNATE,
+                                                SYSCTL_PERIPH_UART0,
+                                                SYSCTL_PERIPH_UART1,
+                                                SYSCTL_PERIPH_UART2,
+                                                SYSCTL_PERIPH_UART3,
+                                                SYSCTL_PERIPH_UART4,
+                                                SYSCTL_PERIPH_UART5,
+                                                SYSCTL_PERIPH_UART6,
+                                                SYSCTL_PERIPH_UART7,
+                                                SYSCTL_PERIPH_SSI0,
+                                                SYSCTL_PERIPH_SSI1,
+                                                SYSCTL_PERIPH_SSI2,
+                                                SYSCTL_PERIPH_SSI3,
+                                                SYSCTL_PERIPH_I2C0,
+                                                SYSCTL_PERIPH_I2C1,
+                                                SYSCTL_PERIPH_I2C2,
+                                                SYSCTL_PERIPH_I2C3,
+                                                SYSCTL_PERIPH_USB0,
+                                                SYSCTL_PERIPH_CAN0,
+                                                SYSCTL_PERIPH_CAN1,
+                                                SYSCTL_PERIPH_ADC0,
+                                                SYSCTL_PERIPH_ADC1,
+                                                SYSCTL_PERIPH_COMP0,
+                                                SYSCTL_PERIPH_PWM0,
+                                                SYSCTL_PERIPH_PWM1,
+                                                SYSCTL_PERIPH_QEI0,
+                                                SYSCTL_PERIPH_QEI1,
+                                                SYSCTL_PERIPH_EEPROM0,
+                                                SYSCTL_PERIPH_WTIMER0,
+                                                SYSCTL_PERIPH_WTIMER1,
+                                                SYSCTL_PERIPH_WTIMER2,
+                                                SYSCTL_PERIPH_WTIMER3,
+                                                SYSCTL_PERIPH_WTIMER4,
+                                                SYSCTL_PERIPH_WTIMER5};
+
+
+extern "C" void SystemFaultHandler(uint32_t *frame)
+{
+    /*
+     * Called by the fault handler of the startup code
+     * (tm4c123gh6pm_startup_ccs.c) with the registers stacked on exception
+     * entry. C linkage, as the startup code is C.
+     *
+     * frame: r0-r3, r12, lr, pc, xPSR of the faulting code.
+     */
+
+    System::cpuFault(frame);
+}
+
 System::System()
 {
     /*
@@ -24,7 +100,7 @@ System::~System()
      */
 }
 
-void System::init(uint32_t clk)
+void System::init(uint32_t clk, uint32_t baud)
 {
     /*
      * Initialize the uC by setting and enabling the CPU clock, the PWM Unit
@@ -34,27 +110,30 @@ void System::init(uint32_t clk)
      * corresponding methods.
      * Note: Call this method before doing anything else in your program!
      *
-     * clk: the desired clock frequency of the CPU in Hz. It can be 40MHz,
-     *      50MHz or 80MHz.
+     * clk:  the desired clock frequency of the CPU in Hz. It can be 20MHz,
+     *       40MHz, 50MHz or 80MHz.
+     * baud: baud rate of the USB UART. The UART supports up to clk/8 (High
+     *       Speed mode). Rates above 115200 (f.ex. 921600 or 1500000) require
+     *       a terminal/driver on the PC supporting them.
      */
 
-    // Configure clock ("TivaC Launchpad Workshop" page 75)
-    if (clk == 40000000)
-    {
-        SysCtlClockSet(SYSCTL_SYSDIV_5 | SYSCTL_USE_PLL | SYSCTL_XTAL_16MHZ
-                       | SYSCTL_OSC_MAIN);
-    }
-    else if (clk == 50000000)
-    {
-        SysCtlClockSet(SYSCTL_SYSDIV_4 | SYSCTL_USE_PLL | SYSCTL_XTAL_16MHZ
-                       | SYSCTL_OSC_MAIN);
-    }
-    else if (clk == 80000000)
-    {
-        SysCtlClockSet(SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_XTAL_16MHZ
-                       | SYSCTL_OSC_MAIN);
-    }
-    else
+    /*
+     * Boot time: The startup code (ResetISR) starts the cycle counter. Until
+     * the PLL is locked the CPU runs with the 16MHz precision oscillator.
+     */
+#ifndef CFG_HOST_SIM
+    systemBootUS[BootStartup] = CycleCounter::get() / 16;
+#endif
+
+    // This instance handles the CPU faults. Without enabling them, MPU, bus
+    // and usage faults escalate to hard faults, which hides their cause.
+    systemActive = this;
+    IntEnable(FAULT_MPU);
+    IntEnable(FAULT_BUS);
+    IntEnable(FAULT_USAGE);
+
+    // Configure clock
+    if (!setPLL(clk))
     {
         error(SysWrongFrequency, &clk);
     }
@@ -62,6 +141,20 @@ void System::init(uint32_t clk)
     // Store the CPU clock
     systemClockFrequency = clk;
 
+    // Exact time for the delays, continuing the boot time.
+#ifndef CFG_HOST_SIM
+    systemBootUS[BootClock] = CycleCounter::get() / 16;
+#endif
+    TimeBase::init(clk, systemBootUS[BootClock]);
+
+    /*
+     * Enable all peripherals used here at once and wait until all of them
+     * are ready instead of waiting for each one.
+     */
+    const uint32_t periphs[4] = {SYSCTL_PERIPH_GPIOA, SYSCTL_PERIPH_UART0,
+                                 SYSCTL_PERIPH_GPIOF, SYSCTL_PERIPH_GPIOD};
+    enablePeripherals(periphs, 4);
+
     /*
      * Set the clock divisor which applies to all PWM modules ("TivaWare(TM)
      * Treiberbibliothek" page 509 and "TivaC Mikrocontroller Datenblatt"
@@ -75,19 +168,12 @@ void System::init(uint32_t clk)
      * Use the USB UART to send debugging data.
      */
 
-     // Enable peripherals
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
-
-    // Wait until peripheral is enabled "TivaWare(TM) Treiberbibliothek"
-    // page 502, "TivaC Launchpad Workshop" page 78)
-    delayCycles(5);
-
     // Configure UART and use it with UARTStdio
     GPIOPinConfigure(GPIO_PA0_U0RX);
     GPIOPinConfigure(GPIO_PA1_U0TX);
     GPIOPinTypeUART(GPIO_PORTA_BASE, GPIO_PIN_0 | GPIO_PIN_1);
-    UARTStdioConfig(0, 115200, getClockFreq());
+    UARTStdioConfig(0, baud, getClockFreq());
+    systemBaud = baud;
 
     /*
      *  Unlock the two Pins PF0 and PD7. Because those can be used for an NMI
@@ -96,14 +182,6 @@ void System::init(uint32_t clk)
      *  afterwards by any other class.
      */
 
-    // Peripherals must be enabled before accessing their registers
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOD);
-
-    // Wait until peripheral is enabled ("TivaWare(TM) Treiberbibliothek"
-    // page 502)
-    delayCycles(5);
-
     // Unlock both pins ("TivaC Launchpad Workshop" page 70, "TivaC
     // Mikrocontroller Datenblatt" page 656)
     HWREG(GPIO_PORTF_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
@@ -113,8 +191,24 @@ void System::init(uint32_t clk)
     HWREG(GPIO_PORTD_BASE + GPIO_O_CR)  |= GPIO_PIN_7;
     HWREG(GPIO_PORTD_BASE + GPIO_O_LOCK) = 0;
 
+    // Durations (f.ex. the profiler).
+    CycleCounter::init();
+
+    // Check what the previous boot left in the black box and record this
+    // boot. Needs the time base.
+    BlackBox::init();
+
+    /*
+     * Split the interrupt priority into preemption priority and subpriority
+     * (see System::setIntPriority). By default all interrupts have the
+     * highest priority (0) until System::setIntPriority is called.
+     */
+    IntPriorityGroupingSet(systemIntPreemptBits);
+
     // Enable interrupts
     IntMasterEnable();
+
+    markBoot(BootSystem);
 }
 
 void System::error(ErrorCodes errorCode, void *faultOrigin0,
@@ -122,8 +216,15 @@ void System::error(ErrorCodes errorCode, void *faultOrigin0,
 {
     /*
      * In case of an error other classes call this method and provide optional
-     * debugging informations. It disables interrupts, stops all the
-     * peripherals of the uC and enters an infinite loop.
+     * debugging informations. It works in three steps:
+     * 1. Disable interrupts and force the registered outputs (see
+     *    System::registerSafeOutput) into their inactive state. This takes a
+     *    fixed number of cycles (a few register writes per output).
+     * 2. Record the error in the black box (see FaultRecord and
+     *    BlackBox::dump), including the CPU registers for CPU faults.
+     * 3. Restart the uC if the error is recoverable (see
+     *    System::setErrorRecoverable). Otherwise stop all the other
+     *    peripherals of the uC and enter an infinite loop.
      *
      * errorCode:   optional error parameter giving informations about the
      *              origin of the fault. Default is UnknownError
@@ -131,19 +232,366 @@ void System::error(ErrorCodes errorCode, void *faultOrigin0,
      *              caused the error.
      */
 
-    // Disable Interrupts
+    // Disable Interrupts. Note: Not System::enterCritical, as the error
+    // handler must silence interrupts of all priorities, including 0.
     IntMasterDisable();
+    enterSafeState();
+
+    // Keep the error for the next boot (f.ex. after a watchdog reset).
+    FaultRecord fault = {};
+    fault.errorCode = errorCode;
+    fault.timestamp = TimeBase::getUS();
+    void *origins[3] = {faultOrigin0, faultOrigin1, faultOrigin2};
+    for (uint_fast8_t i = 0; i < 3; i++)
+    {
+        // For smaller variables only the lowest bytes are meaningful.
+        fault.origins[i] = (uint32_t) (uintptr_t) origins[i];
+        if (isSafeToRead(origins[i], sizeof(uint32_t)))
+        {
+            memcpy(&fault.values[i], origins[i], sizeof(uint32_t));
+        }
+    }
+    if (errorCode == CPUFault)
+    {
+        if (isSafeToRead(faultOrigin0, sizeof(fault.stacked)))
+        {
+            memcpy(fault.stacked, faultOrigin0, sizeof(fault.stacked));
+        }
+#ifndef CFG_HOST_SIM
+        // "TivaC Mikrocontroller Datenblatt", chapter "System Control Block"
+        fault.faultStatus[0] = HWREG(NVIC_FAULT_STAT);
+        fault.faultStatus[1] = HWREG(NVIC_HFAULT_STAT);
+        fault.faultStatus[2] = HWREG(NVIC_MM_ADDR);
+        fault.faultStatus[3] = HWREG(NVIC_FAULT_ADDR);
+#endif
+    }
+    BlackBox::recordFault(fault);
+
+    // Restart the control loop, unless the error keeps coming back.
+    if ((errorCode < 32) && (systemRecoverableErrors & (1 << errorCode))
+        && (BlackBox::getRestarts() < systemMaxRestarts))
+    {
+        BlackBox::countRestart();
+        SysCtlReset();
+    }
 
-    // Stop all peripherals
+    // Stop all other peripherals. Resetting the GPIO ports of the safe
+    // outputs would make them floating inputs.
     for (uint_fast8_t i = 0; i < systemPeripheralsCount; i++)
     {
-        SysCtlPeripheralReset(systemPeripherals[i]);
-        SysCtlPeripheralDisable(systemPeripherals[i]);
+        bool safePort = false;
+        for (uint_fast8_t j = 0; j < systemSafeOutputCount; j++)
+        {
+            safePort |= (systemSafeOutputs[j].periph == systemPeripherals[i]);
+        }
+        if (!safePort)
+        {
+            SysCtlPeripheralReset(systemPeripherals[i]);
+            SysCtlPeripheralDisable(systemPeripherals[i]);
+        }
+    }
+
+    while (42);
+}
+
+void System::registerSafeOutput(uint32_t portBase, uint8_t pins,
+                                uint8_t inactiveLevel)
+{
+    /*
+     * Register outputs which System::error must switch off first, f.ex. the
+     * PWM outputs and the enable pin of the motor driver. In case of an
+     * error the pins are switched to GPIO outputs (also if they are used by
+     * a peripheral like the PWM module) with the given level.
+     * Note: The GPIO port must be enabled already.
+     *
+     * portBase:      Base address of the GPIO port.
+     * pins:          GPIO_PIN_... (can be combined).
+     * inactiveLevel: Level of each pin (same bit as the pin) in the safe
+     *                state, f.ex. 0 for all low or the pins for all high.
+     */
+
+    uint32_t periph = getGPIOPeriph(portBase);
+    if (!periph || (systemSafeOutputCount >= systemMaxSafeOutputs))
+    {
+        error(SysWrongSafeOutput, &portBase);
     }
 
+    SafeOutput &output = systemSafeOutputs[systemSafeOutputCount];
+    output.portBase = portBase;
+    output.periph = periph;
+    output.pins = pins;
+    output.level = inactiveLevel & pins;
+    systemSafeOutputCount++;
+}
+
+void System::setErrorRecoverable(ErrorCodes errorCode, bool recoverable)
+{
+    /*
+     * Select whether System::error restarts the uC after the given error
+     * instead of halting forever. After <systemMaxRestarts> restarts in a
+     * row it halts anyway; the application confirms that it runs properly
+     * again with BlackBox::clearRestarts.
+     * By default no error is recoverable.
+     *
+     * errorCode:   The error.
+     * recoverable: true to restart after this error.
+     */
+
+    if (errorCode >= 32)
+    {
+        return;
+    }
+    if (recoverable)
+    {
+        systemRecoverableErrors |= (1 << errorCode);
+    }
+    else
+    {
+        systemRecoverableErrors &= ~(1 << errorCode);
+    }
+}
+
+void System::cpuFault(uint32_t *frame)
+{
+    /*
+     * Handle a CPU fault (hard, memory management, bus or usage fault) like
+     * an error (System::error with CPUFault). Called by the fault handler of
+     * the startup code, see SystemFaultHandler.
+     *
+     * frame: Registers stacked on exception entry.
+     */
+
+    if (systemActive)
+    {
+        systemActive->error(CPUFault, frame);
+    }
+
+    // Fault before System::init: nothing is known about the outputs.
+    IntMasterDisable();
     while (42);
 }
 
+bool System::setPLL(uint32_t clk)
+{
+    /*
+     * Run the CPU with the given clock frequency, derived from the 200MHz PLL
+     * ("TivaC Launchpad Workshop" page 75). Returns false if the frequency is
+     * not supported (see System::init).
+     *
+     * clk: The clock frequency of the CPU in Hz.
+     */
+
+    const uint32_t settings[4][2] = {{20000000, SYSCTL_SYSDIV_10},
+                                     {40000000, SYSCTL_SYSDIV_5},
+                                     {50000000, SYSCTL_SYSDIV_4},
+                                     {80000000, SYSCTL_SYSDIV_2_5}};
+
+    for (uint_fast8_t i = 0; i < 4; i++)
+    {
+        if (settings[i][0] == clk)
+        {
+            SysCtlClockSet(settings[i][1] | SYSCTL_USE_PLL | SYSCTL_XTAL_16MHZ
+                           | SYSCTL_OSC_MAIN);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t System::drainDebugTx()
+{
+    /*
+     * Wait until the debug data being transmitted is complete and start a
+     * critical section (see System::enterCritical) so that no new
+     * transmission starts. Returns the state for System::exitCritical.
+     */
+
+    uint32_t state = enterCritical();
+    while (systemTxBusy)
+    {
+        exitCritical(state);
+        state = enterCritical();
+    }
+    while (UARTBusy(UART0_BASE));
+    return state;
+}
+
+bool System::isSafeToRead(const void *address, uint32_t length)
+{
+    /*
+     * Returns true if the given memory can be read without causing another
+     * fault: it must lie completely in the SRAM (0x20000000-0x20007fff, see
+     * "TivaC Mikrocontroller Datenblatt", chapter "Memory Map") and be word
+     * aligned. Used by System::error, where the pointers (f.ex. the stack
+     * pointer after a stack overflow) may be corrupt and a fault inside the
+     * fault handler would lock up the CPU.
+     * On the host every pointer except null is accepted.
+     *
+     * address: First byte to read.
+     * length:  Number of bytes to read.
+     */
+
+#ifdef CFG_HOST_SIM
+    (void) length;
+    return address;
+#else
+    uintptr_t start = (uintptr_t) address;
+    return (start >= 0x20000000) && (start % 4 == 0)
+           && (length <= 0x8000) && (start - 0x20000000 <= 0x8000 - length);
+#endif
+}
+
+void System::enterSafeState()
+{
+    /*
+     * Force all registered outputs into their inactive state. Direct register
+     * accesses, as this must be fast and must not depend on any other state.
+     * The data register is written through its address mask, so only the
+     * given pins are affected ("TivaC Mikrocontroller Datenblatt", GPIO
+     * chapter, section "Data Register Operation").
+     */
+
+#ifndef CFG_HOST_SIM
+    for (uint_fast8_t i = 0; i < systemSafeOutputCount; i++)
+    {
+        const SafeOutput &output = systemSafeOutputs[i];
+        HWREG(output.portBase + GPIO_O_DATA + (output.pins << 2)) = output.level;
+        HWREG(output.portBase + GPIO_O_DIR)  |= output.pins;
+        HWREG(output.portBase + GPIO_O_AFSEL) &= ~output.pins;
+    }
+#endif
+}
+
+uint32_t System::setClockFreq(uint32_t clk)
+{
+    /*
+     * Change the CPU clock at runtime, f.ex. to save power in standby. The
+     * debug UART is reconfigured for the new clock; all other peripherals
+     * using the CPU clock (timers, PWM, I2C, SSI) must be updated by the
+     * caller afterwards, f.ex. with Timer::setFreq.
+     * No ISR may run with the wrong clock frequency, therefore the method
+     * returns inside a critical section (see System::enterCritical). The
+     * caller ends it with System::exitCritical once all peripherals are
+     * updated:
+     *   uint32_t state = sys->setClockFreq(clk);
+     *   timer.setFreq(...);
+     *   sys->exitCritical(state);
+     * The ISRs of preemption priority 0 are not masked; they only see the
+     * old or the new clock (with a consistent time base), but may run
+     * before the peripherals are updated (see Segway::updateClock).
+     * Note: Waits until the debug data being transmitted is complete. Do not
+     *       call it from an ISR.
+     *
+     * clk: The new clock frequency, see System::init.
+     */
+
+    if ((clk == systemClockFrequency) || !systemBaud)
+    {
+        return enterCritical();
+    }
+
+    // The bytes in flight must still be sent with the old baud rate
+    // divisor.
+    uint32_t state = drainDebugTx();
+
+    // The critical section does not mask the foot switch ISRs (preemption
+    // priority 0), which read the time base and restart their timer with
+    // the current clock. So the clock, systemClockFrequency and the time
+    // base are changed together with all interrupts disabled. This only
+    // takes about a hundred cycles, as the PLL stays locked (only the
+    // divider changes).
+    bool disabled = IntMasterDisable();
+    if (!setPLL(clk))
+    {
+        error(SysWrongFrequency, &clk);
+    }
+    systemClockFrequency = clk;
+    TimeBase::updateClock(clk);
+    if (!disabled)
+    {
+        IntMasterEnable();
+    }
+    UARTStdioConfig(0, systemBaud, clk);
+
+    return state;
+}
+
+void System::deepSleep(uint32_t wakeInt0, uint32_t wakeInt1)
+{
+    /*
+     * Enter deep-sleep ("TivaC Mikrocontroller Datenblatt", chapter "Power
+     * Control") until one of the given interrupts occurs. Meanwhile only the
+     * peripherals enabled with SysCtlPeripheralDeepSleepEnable run (from the
+     * 30kHz oscillator); all others, including the timers and the PLL, stop.
+     * On wake-up the hardware restores the run mode clock.
+     * The caller configures the interrupt sources of the peripherals (f.ex.
+     * GPIOIntEnable) before and clears them afterwards. The given interrupts
+     * are only enabled in the NVIC while sleeping and never reach an ISR,
+     * unless they were enabled before (then their ISR handles them after the
+     * wake-up).
+     * Note: Waits until the debug data being transmitted is complete. Do not
+     *       call it from an ISR.
+     *
+     * wakeInt: Interrupts (INT_...) waking the uC. 0 if unused.
+     */
+
+    uint32_t wakeInts[2] = {wakeInt0, wakeInt1};
+    bool wasEnabled[2];
+
+    // Interrupts stay disabled, pending interrupts still end the sleep.
+    uint32_t state = drainDebugTx();
+    IntMasterDisable();
+    exitCritical(state);
+
+    for (uint_fast8_t i = 0; i < 2; i++)
+    {
+        wasEnabled[i] = wakeInts[i] && IntIsEnabled(wakeInts[i]);
+    }
+    for (uint_fast8_t i = 0; i < 2; i++)
+    {
+        if (wakeInts[i] && !wasEnabled[i])
+        {
+            IntPendClear(wakeInts[i]);
+            IntEnable(wakeInts[i]);
+        }
+    }
+
+    SysCtlDeepSleepClockSet(SYSCTL_DSLP_DIV_1 | SYSCTL_DSLP_OSC_INT30);
+    SysCtlPeripheralClockGating(true);
+    SysCtlDeepSleep();
+    SysCtlPeripheralClockGating(false);
+
+    for (uint_fast8_t i = 0; i < 2; i++)
+    {
+        if (wakeInts[i] && !wasEnabled[i])
+        {
+            IntDisable(wakeInts[i]);
+            IntPendClear(wakeInts[i]);
+        }
+    }
+
+    IntMasterEnable();
+}
+
+uint32_t System::getGPIOPeriph(uint32_t portBase)
+{
+    /*
+     * Returns the peripheral (SYSCTL_PERIPH_GPIO...) of the given GPIO port
+     * or 0 if the port does not exist.
+     *
+     * portBase: Base address of the GPIO port.
+     */
+
+    for (uint_fast8_t i = 0; i < 6; i++)
+    {
+        if (systemGPIOPorts[i][0] == portBase)
+        {
+            return systemGPIOPorts[i][1];
+        }
+    }
+    return 0;
+}
+
 uint32_t System::getClockFreq()
 {
     /*
@@ -183,35 +631,104 @@ uint32_t System::getPWMClockDiv()
 void System::delayCycles(uint32_t cycles)
 {
     /*
-     * Halt the CPU for at least the given amount of cycles.
-     * Note: Because this function uses SysCtlDelay (see "TivaWare(TM)
-     *       Treiberbibliothek" page 489) only multiples of 3 clock cycles are
-     *       possible. Any other value will be rounded up to the next multiple.
+     * Halt the CPU for at least the given amount of cycles. Busy-waits on
+     * the cycle counter, so unlike SysCtlDelay the duration does not depend
+     * on the flash wait states; it exceeds the given amount by a few cycles
+     * at most (plus the duration of interrupts meanwhile).
      *
      * cycles: Minimum number of clock cycles to halt the CPU
      */
 
-    // To round up in an integer division of p by q, you have to increase
-    // p by q-1
-    cycles = (cycles + 2) / 3;
-    SysCtlDelay(cycles);
+    // The unsigned difference is correct across an overflow of the counter.
+    uint32_t start = CycleCounter::get();
+    while ((uint32_t) (CycleCounter::get() - start) < cycles);
 }
 
-void System::delayUS(uint32_t us)
+void System::delayUS(uint64_t us)
 {
     /*
-     * Halt the CPU for at least the given amount of microseconds.
-     * Note: Because this function uses SysCtlDelay (see "TivaWare(TM)
-     *       Treiberbibliothek" page 489) only multiples of 3 clock cycles are
-     *       possible. Any other value will be rounded up to the next multiple.
+     * Halt the program for at least the given amount of microseconds. The
+     * CPU sleeps meanwhile and interrupts are still handled (see
+     * TimeBase::delayUS). Any duration is possible.
+     * Note: Do not call it from an ISR.
      *
      * us: Minimum delay in microseconds
      */
 
-    // Convert to clock cycles
-    us *= getClockFreq() / 1000000;
+    TimeBase::delayUS(us);
+}
+
+void System::setIntPriority(uint32_t interrupt, uint32_t preempt,
+                            uint32_t sub)
+{
+    /*
+     * Assign a priority to an interrupt source. An interrupt can only
+     * interrupt (preempt) an ISR with a higher preemption priority value.
+     * If two interrupts with the same preemption priority are pending, the
+     * one with the lower subpriority value is handled first.
+     * Priority plan (see Config.h):
+     *   0: Reserved. Never masked by System::enterCritical.
+     *   1: Control loop (main timer, sensor).
+     *   2: Measurements (ADC).
+     *   3: Telemetry (UART, debug timer).
+     *
+     * interrupt: The interrupt (f.ex. INT_TIMER0A, see inc/hw_ints.h)
+     * preempt:   Preemption priority, 0 (highest) to 3 (lowest).
+     * sub:       Optional subpriority, 0 (highest, default) or 1 (lowest).
+     */
+
+    if ((preempt >= (1 << systemIntPreemptBits))
+        || (sub >= (1 << (systemIntPrioBits - systemIntPreemptBits))))
+    {
+        error(SysWrongIntPriority, &interrupt, &preempt, &sub);
+    }
+
+    // Only the upper bits of the 8 bit priority register are implemented
+    // ("TivaC Mikrocontroller Datenblatt" page 152).
+    uint32_t priority = (preempt << (systemIntPrioBits - systemIntPreemptBits))
+                        | sub;
+    IntPrioritySet(interrupt, priority << (8 - systemIntPrioBits));
+}
+
+uint32_t System::enterCritical(uint32_t preempt)
+{
+    /*
+     * Start a critical section by masking all interrupts with the given
+     * or a lower preemption priority (BASEPRI register). Unlike
+     * IntMasterDisable, more urgent interrupts can still preempt the critical
+     * section. Returns the previous state that must be given to
+     * System::exitCritical at the end of the critical section.
+     * Critical sections can be nested.
+     * Example:
+     *   uint32_t state = sys->enterCritical();
+     *   // Access data shared with ISRs of preemption priority 1-3
+     *   sys->exitCritical(state);
+     *
+     * preempt: Optional preemption priority. Default is 1 which masks all
+     *          interrupts except the reserved priority 0.
+     */
+
+    uint32_t state = IntPriorityMaskGet();
+    uint32_t mask = (preempt << (systemIntPrioBits - systemIntPreemptBits))
+                    << (8 - systemIntPrioBits);
+
+    // Never unmask anything if an outer critical section masks more.
+    if ((state == 0) || (mask < state))
+    {
+        IntPriorityMaskSet(mask);
+    }
+    return state;
+}
+
+void System::exitCritical(uint32_t state)
+{
+    /*
+     * End a critical section started by System::enterCritical.
+     *
+     * state: The value returned by the corresponding System::enterCritical.
+     */
 
-    delayCycles(us);
+    IntPriorityMaskSet(state);
 }
 
 void System::setDebugging(bool debug)
@@ -219,29 +736,114 @@ void System::setDebugging(bool debug)
     /*
      * Enable or disable the transmission of debugging data via UART.
      * By default debugging is enabled.
+     * Note: When (re-)enabling, the labels are sent again, as the receiver
+     *       may have received other data meanwhile. When disabling, this
+     *       waits until the transmit queue is empty.
      */
     systemDebugEnabled = debug;
+    if (debug)
+    {
+        systemDebugLabels++;
+    }
+    else
+    {
+        // Other output (f.ex. UARTprintf) must not get mixed with queued data.
+        flushDebugTx();
+    }
 }
 
-void System::setDebugVal(const char* name, int32_t value)
+void System::setDebugFormat(DebugFormat format)
+{
+    /*
+     * Select the transmission format of the debug values (see
+     * System::sendDebugVals). The default is DebugText.
+     *
+     * format: DebugText, DebugBinary or DebugCompressed.
+     */
+
+    systemDebugFormat = format;
+    systemDebugLabels++;
+}
+
+bool System::getDebugging()
+{
+    /*
+     * Returns true if the debugging data is transmitted (see
+     * System::setDebugging). Text reports (f.ex. System::reportBoot) pause
+     * it and restore this state afterwards.
+     */
+
+    return systemDebugEnabled;
+}
+
+DebugFormat System::getDebugFormat()
+{
+    /*
+     * Returns the transmission format of the debug values (see
+     * System::setDebugFormat). Text reports are only sent with DebugText;
+     * within the binary formats the receiver would merge them with the
+     * next frame and drop both because of the wrong CRC.
+     */
+
+    return systemDebugFormat;
+}
+
+void System::beginDebugUpdate()
+{
+    /*
+     * Mark the start of a consistent set of debug value updates, usually
+     * one control cycle. All System::setDebugVal calls until
+     * System::endDebugUpdate are transmitted together or not at all.
+     * Note: This never blocks and does not disable interrupts. It must
+     *       only be called from one context (f.ex. the control ISR) which
+     *       must have a higher priority than the one calling
+     *       System::sendDebugVals.
+     */
+
+    systemDebugSeq++;
+    systemDebugTimestamp = TimeBase::getUS();
+    memoryBarrier();
+}
+
+void System::endDebugUpdate()
+{
+    /*
+     * Mark the end of a consistent set of debug value updates (see
+     * System::beginDebugUpdate).
+     */
+
+    memoryBarrier();
+    systemDebugSeq++;
+}
+
+DebugHandle System::registerDebugVal(const char* name, DebugType type)
 {
     /*
-     * Set up to <systemMaxDebugVals> values to monitor via USB UART (Serial
-     * Monitor or Serial Plotter).
+     * Register a value to monitor via USB UART (Serial Monitor or Serial
+     * Plotter) and return its handle. Up to <systemMaxDebugVals> values can
+     * be registered. New values are enabled.
      * Example:
      *   You have two functions that use debugging. Function foo watches 1
      *   value, function bar watches 2 values. Of course you do not want to
      *   overwrite the values from foo inside bar and vice-versa.
-     *   Therefore you write inside foo:
-     *      fooSys->setDebugVal("My Foo Value", fooValue);
+     *   Therefore you register them once during initialization:
+     *      fooHandle  = fooSys->registerDebugVal("My Foo Value");
+     *      barHandle1 = barSys->registerDebugVal("My first Bar Value");
+     *      barHandle2 = barSys->registerDebugVal("My second Bar Value");
+     *   And update them inside foo:
+     *      fooSys->setDebugVal(fooHandle, fooValue);
      *   And inside bar:
-     *      barSys->setDebugVal("My first Bar Value",  barValue1);
-     *      barSys->setDebugVal("My second Bar Value", barValue2);
+     *      barSys->setDebugVal(barHandle1, barValue1);
+     *      barSys->setDebugVal(barHandle2, barValue2);
      * Notes:
+     *   * Register all values during initialization, not from an ISR.
      *   * If you use the Arduino Serial Plotter your Arduino IDE needs to be
      *     v1.8.10 or newer.
      *   * Values are transmitted at 115200 baud.
-     *   * Transmission format (details under System::sendDebugVals()):
+     *   * Float values need the type DebugFloat and are updated with
+     *     System::setDebugValFloat. The text format sends them with 2
+     *     decimals unless changed with System::setDebugValDecimals.
+     *   * Text transmission format (details under System::sendDebugVals()):
      *     Label_1\tLabel_2\tLabel_3\n
      *     Value_1\tValue_2\tValue_3\n
      *     Value_1\tValue_2\tValue_3\n
@@ -254,92 +856,748 @@ void System::setDebugVal(const char* name, int32_t value)
      *
      * name:  String with name that shall be shown in Serial Plotter legend.
      *        Must not contain ","  "\t"  " " or "\n".
-     * value: Integer value to transmit.
+     * type:  Data type of the value (only relevant for the binary format).
      */
 
-    if (systemDebugEnabled)
+    // Already registered?
+    for (uint_fast8_t i = 0; i < systemDebugCount; i++)
     {
-        /*
-         * Check if this variable is already being watched and if not, check
-         * if there's space for a new variable. In either case the
-         * corresponding value is updated.
-         */
-        for(uint_fast8_t i = 0; i < systemMaxDebugVals; i++)
+        if (systemDebugNames[i] == name)
         {
-            if (systemDebugNames[i] == name)
-            {
-                systemDebugVals[i]  = value;
-                return;
-            }
-            else if (systemDebugNames[i] == systemDebugUnused)
-            {
-                systemDebugVals[i]  = value;
-                systemDebugNames[i] = name;
-                systemDebugNewLabel = true;
-                return;
-            }
+            return i;
         }
+    }
 
+    if (systemDebugCount >= systemMaxDebugVals)
+    {
         /*
-         * If we did not reach a return statement in the for loop we have a
-         * new variable but no space for it and want to set the according flag.
-         * This must be done only once otherwise System::sendDebugValues will
-         * send labels only (because systemDebugNewLabel would always be true).
+         * New variable but no space for it. The flag must be set only once
+         * otherwise System::sendDebugValues will send labels only (because
+         * systemDebugLabels would always change).
+         * The returned handle points to the spare value which is never sent.
          */
         if (!systemTooManyDebugVals)
         {
             systemTooManyDebugVals = true;
-            systemDebugNewLabel = true;
+            systemDebugLabels++;
         }
+        return systemMaxDebugVals;
     }
+
+    DebugHandle handle = systemDebugCount;
+    systemDebugVals[handle].i = 0;
+    systemDebugNames[handle] = name;
+    systemDebugTypes[handle] = type;
+    systemDebugDecimals[handle] = systemDebugDefaultDecimals;
+    systemDebugEnabledMask[handle / 32] |= (1 << (handle % 32));
+
+    // The entry must be complete before the sending ISR can see it.
+    memoryBarrier();
+    systemDebugCount++;
+    systemDebugLabels++;
+
+    return handle;
 }
 
-void System::sendDebugVals()
+void System::setDebugValEnabled(DebugHandle handle, bool enabled)
 {
     /*
-     * If debugging is enabled, send data to PC via UART. Unused values are
-     * skipped.
-     * This method should be called periodically (f.ex. 10Hz Timer interrupt)
+     * Enable or disable the transmission of a registered debug value. This
+     * allows to register many values but to only send those of interest.
+     *
+     * handle:  The handle returned by System::registerDebugVal.
+     * enabled: Whether the value shall be transmitted.
+     */
+
+    if (handle >= systemDebugCount)
+    {
+        return;
+    }
+
+    if (enabled)
+    {
+        systemDebugEnabledMask[handle / 32] |= (1 << (handle % 32));
+    }
+    else
+    {
+        systemDebugEnabledMask[handle / 32] &= ~(1 << (handle % 32));
+    }
+    systemDebugLabels++;
+}
+
+void System::setDebugValDecimals(DebugHandle handle, uint_fast8_t decimals)
+{
+    /*
+     * Set the number of decimals of a float value in the text format. Has
+     * no effect on integer values and the binary format.
+     *
+     * handle:   The handle returned by System::registerDebugVal.
+     * decimals: Number of decimals (0 - 6).
+     */
+
+    if (handle < systemDebugCount)
+    {
+        systemDebugDecimals[handle] = decimals;
+    }
+}
+
+void System::setDebugVal(const char* name, int32_t value)
+{
+    /*
+     * Set a value to monitor via USB UART. The value is registered on the
+     * first call (see System::registerDebugVal).
+     * Note: This needs to search the channel table at each call. In time
+     *       critical code use System::registerDebugVal once and
+     *       System::setDebugVal with the handle instead.
+     *
+     * name:  String with name that shall be shown in Serial Plotter legend.
+     *        Must not contain ","  "\t"  " " or "\n".
+     * value: Integer value to transmit.
      */
 
     if (systemDebugEnabled)
     {
-        if (systemDebugNewLabel)
+        setDebugVal(registerDebugVal(name), value);
+    }
+}
+
+void System::sendDebugVals()
+{
+    /*
+     * If debugging is enabled, send data to PC via UART. Disabled values are
+     * skipped. The format is selected with System::setDebugFormat.
+     * This method should be called periodically (f.ex. 10Hz Timer interrupt)
+     */
+
+    if (systemDebugEnabled && takeDebugSnapshot())
+    {
+        if ((systemDebugFormat == DebugBinary)
+            || (systemDebugFormat == DebugCompressed))
+        {
+            sendDebugBinary();
+        }
+        else
+        {
+            sendDebugText();
+        }
+    }
+}
+
+bool System::takeDebugSnapshot()
+{
+    /*
+     * Take a consistent snapshot of the debug values (sequence lock, see
+     * System::beginDebugUpdate). If the control ISR interrupts the copy,
+     * the sequence changes and the copy is repeated. If it is still
+     * inconsistent after a few tries, false is returned and this
+     * transmission should be skipped.
+     */
+
+    DebugSnapshot &snap = systemDebugSnapshot;
+    uint32_t seq;
+    uint_fast8_t tries = 0;
+    do
+    {
+        if (tries++ >= systemDebugMaxRetries)
+        {
+            return false;
+        }
+
+        seq = systemDebugSeq;
+        memoryBarrier();
+        snap.count = systemDebugCount;
+        memoryBarrier();
+        for (uint_fast8_t i = 0; i < snap.count; i++)
+        {
+            snap.vals[i]  = systemDebugVals[i];
+            snap.names[i] = systemDebugNames[i];
+            snap.types[i] = systemDebugTypes[i];
+            snap.decimals[i] = systemDebugDecimals[i];
+        }
+        for (uint_fast8_t i = 0; i < systemDebugMaskWords; i++)
+        {
+            snap.enabled[i] = systemDebugEnabledMask[i];
+        }
+        snap.labels    = systemDebugLabels;
+        snap.tooMany   = systemTooManyDebugVals;
+        snap.timestamp = systemDebugTimestamp;
+        memoryBarrier();
+    } while ((seq & 1) || (seq != systemDebugSeq));
+
+    // Without System::beginDebugUpdate the time of transmission is used.
+    if (seq == 0)
+    {
+        snap.timestamp = TimeBase::getUS();
+    }
+    return true;
+}
+
+void System::sendDebugText()
+{
+    /*
+     * Send the snapshot as text for the Arduino serial plotter. The lines are
+     * rendered with TelemetryText and handed to the transmit queue, so with
+     * the uDMA (see System::enableDebugDMA) this does not block.
+     */
+
+    DebugSnapshot &snap = systemDebugSnapshot;
+
+    if (snap.labels != systemDebugSentLabels)
+    {
+        /*
+         * Labels are only transmitted if there's a new one. The result
+         * in the Arduino serial plotter will be the same but it requires
+         * far less time to transmit the values compared to sending the
+         * labels at each value update.
+         * See https://github.com/arduino/Arduino/blob/master/build/shared/
+         * ArduinoSerialPlotterProtocol.md
+         */
+        systemDebugText.begin();
+        for (uint_fast8_t i = 0; i < snap.count; i++)
         {
-            /*
-             * Labels are only transmitted if there's a new one. The result
-             * in the Arduino serial plotter will be the same but it requires
-             * far less time to transmit the values compared to sending the
-             * labels at each value update.
-             * See https://github.com/arduino/Arduino/blob/master/build/shared/
-             * ArduinoSerialPlotterProtocol.md
-             */
-            for (uint_fast8_t i = 0; i < systemMaxDebugVals; i++)
+            if (snap.enabled[i / 32] & (1 << (i % 32)))
             {
-                if (systemDebugNames[i] != systemDebugUnused)
-                {
-                    UARTprintf("%s\t", systemDebugNames[i]);
-                }
+                systemDebugText.putString(snap.names[i]);
+                systemDebugText.putChar('\t');
             }
-            if (systemTooManyDebugVals)
+        }
+        if (snap.tooMany)
+        {
+            systemDebugText.putString("Too_many_debug_values");
+        }
+        systemDebugText.endLine();
+
+        // If the queue is full, the labels are tried again next time.
+        if (queueDebugTx(systemDebugText.getData(),
+                         systemDebugText.getLength()))
+        {
+            systemDebugSentLabels = snap.labels;
+        }
+    }
+
+    /*
+     * Normal operation. Send values only.
+     */
+    renderDebugValues();
+    queueDebugTx(systemDebugText.getData(), systemDebugText.getLength());
+}
+
+void System::renderDebugValues()
+{
+    /*
+     * Render the values of the snapshot as one text line into
+     * systemDebugText. Integers are formatted like UARTprintf("%04d\t").
+     */
+
+    DebugSnapshot &snap = systemDebugSnapshot;
+
+    systemDebugText.begin();
+    for (uint_fast8_t i = 0; i < snap.count; i++)
+    {
+        if (snap.enabled[i / 32] & (1 << (i % 32)))
+        {
+            if (snap.types[i] == DebugFloat)
+            {
+                systemDebugText.putFixed(snap.vals[i].f, snap.decimals[i]);
+            }
+            else
             {
-                UARTprintf("%s", "Too_many_debug_values");
+                systemDebugText.putInt(snap.vals[i].i, 4);
             }
-            UARTprintf("\n");
-            systemDebugNewLabel = false;
+            systemDebugText.putChar('\t');
         }
-        
-        /*
-         * Normal operation. Send values only.
-         */
-        for (uint_fast8_t i = 0; i < systemMaxDebugVals; i++)
+    }
+    systemDebugText.endLine();
+}
+
+void System::sendDebugBinary()
+{
+    /*
+     * Send the snapshot as binary frames (see TelemetryFrame.h). All
+     * multi-byte values are little endian.
+     * Channel frame (one per enabled channel, sent whenever the channels
+     * change and every <systemDebugDescrPeriod> data frames):
+     *   uint8_t  type = TELEMETRY_FRAME_CHANNEL
+     *   uint16_t frame counter
+     *   uint8_t  layout (lowest byte of the label counter)
+     *   uint8_t  position of the channel inside the data frame
+     *   uint8_t  number of channels inside the data frame
+     *   uint8_t  DebugType of the channel
+     *   char[]   name (without terminating zero)
+     * Data frame:
+     *   uint8_t  type = TELEMETRY_FRAME_DATA
+     *   uint16_t frame counter
+     *   uint32_t timestamp of the control cycle in us
+     *   uint8_t  layout (must match the channel frames)
+     *   uint8_t  flags (bit 0: too many debug values)
+     *   ...      values of all enabled channels: int16, int32 or float
+     * Delta frame (only DebugCompressed, see below):
+     *   uint8_t  type = TELEMETRY_FRAME_DELTA
+     *   uint16_t frame counter
+     *   varint   time since the previous data or delta frame in us
+     *   uint8_t  layout
+     *   uint8_t  flags
+     *   varint   zigzag(value - previous value) of all enabled channels
+     * The encoding time is bounded: each of the at most <systemMaxDebugVals>
+     * channels needs at most TELEMETRY_VARINT_MAX bytes. A delta frame is
+     * therefore at most one byte per channel (and one for the timestamp)
+     * longer than a data frame and always fits into TelemetryFrame.
+     */
+
+    DebugSnapshot &snap = systemDebugSnapshot;
+    uint8_t layout = snap.labels;
+
+    uint_fast8_t enabledCount = 0;
+    for (uint_fast8_t i = 0; i < snap.count; i++)
+    {
+        if (snap.enabled[i / 32] & (1 << (i % 32)))
+        {
+            enabledCount++;
+        }
+    }
+
+    bool described = false;
+    if ((snap.labels != systemDebugSentLabels)
+        || (systemDebugFramesSinceDescr >= systemDebugDescrPeriod))
+    {
+        described = true;
+        systemDebugSentLabels = snap.labels;
+        systemDebugFramesSinceDescr = 0;
+
+        uint_fast8_t position = 0;
+        for (uint_fast8_t i = 0; i < snap.count; i++)
+        {
+            if (snap.enabled[i / 32] & (1 << (i % 32)))
+            {
+                uint32_t nameLength = 0;
+                while (snap.names[i][nameLength]
+                       && (nameLength < systemDebugMaxNameLength))
+                {
+                    nameLength++;
+                }
+
+                systemDebugFrame.begin(TELEMETRY_FRAME_CHANNEL);
+                systemDebugFrame.putU16(systemDebugFrameCount++);
+                systemDebugFrame.putU8(layout);
+                systemDebugFrame.putU8(position++);
+                systemDebugFrame.putU8(enabledCount);
+                systemDebugFrame.putU8(snap.types[i]);
+                systemDebugFrame.putBytes(snap.names[i], nameLength);
+                sendDebugFrame();
+            }
+        }
+    }
+    systemDebugFramesSinceDescr++;
+
+    // Microseconds since the reset. The lowest 32 bits suffice, as the
+    // difference of two frames is computed modulo 2^32.
+    uint32_t timestamp = snap.timestamp;
+
+    /*
+     * Compressed format: Most frames only contain the difference to the
+     * previous frame. A keyframe is sent if the channels changed (the
+     * previous values belong to other channels) and periodically so that
+     * the host can resynchronize after a lost frame.
+     */
+    bool keyframe = (systemDebugFormat != DebugCompressed)
+                    || described
+                    || (systemDebugFramesSinceKey >= systemDebugKeyPeriod);
+
+    if (keyframe)
+    {
+        systemDebugFramesSinceKey = 0;
+        systemDebugFrame.begin(TELEMETRY_FRAME_DATA);
+        systemDebugFrame.putU16(systemDebugFrameCount++);
+        systemDebugFrame.putU32(timestamp);
+    }
+    else
+    {
+        systemDebugFrame.begin(TELEMETRY_FRAME_DELTA);
+        systemDebugFrame.putU16(systemDebugFrameCount++);
+        systemDebugFrame.putVarint(timestamp - systemDebugLastFrameTime);
+    }
+    systemDebugFramesSinceKey++;
+    systemDebugLastFrameTime = timestamp;
+    systemDebugFrame.putU8(layout);
+    systemDebugFrame.putU8(snap.tooMany ? 1 : 0);
+
+    for (uint_fast8_t i = 0; i < snap.count; i++)
+    {
+        if (snap.enabled[i / 32] & (1 << (i % 32)))
         {
-            if (systemDebugNames[i] != systemDebugUnused)
+            // int32 and float are both handled as their raw 32 bits.
+            int32_t value = snap.vals[i].i;
+            if (snap.types[i] == DebugInt16)
+            {
+                if (value > INT16_MAX)
+                {
+                    value = INT16_MAX;
+                }
+                else if (value < INT16_MIN)
+                {
+                    value = INT16_MIN;
+                }
+            }
+
+            if (!keyframe)
             {
-                UARTprintf("%04d\t", systemDebugVals[i]);
+                // Wraps around for large differences, which the host
+                // reverses with the same 32 bit arithmetic.
+                uint32_t delta = value - systemDebugPrevVals[i];
+                systemDebugFrame.putVarint(TelemetryFrame::zigzag((int32_t) delta));
             }
+            else if (snap.types[i] == DebugInt16)
+            {
+                systemDebugFrame.putU16(value);
+            }
+            else
+            {
+                systemDebugFrame.putU32(value);
+            }
+            systemDebugPrevVals[i] = value;
+        }
+    }
+    sendDebugFrame();
+}
+
+void System::sendDebugFrame()
+{
+    /*
+     * Complete and transmit the current telemetry frame. uartstdio cannot be
+     * used as it converts "\n" (0x0a) to "\r\n".
+     */
+
+    uint32_t length = systemDebugFrame.finish();
+    queueDebugTx(systemDebugFrame.getData(), length);
+}
+
+void System::initDMA()
+{
+    /*
+     * Enable the uDMA controller and set its channel control table. Classes
+     * using the uDMA call this method before configuring their channel. It
+     * can be called several times.
+     */
+
+    if (systemDMAEnabled)
+    {
+        return;
+    }
+
+    enablePeripheral(SYSCTL_PERIPH_UDMA);
+
+    uDMAEnable();
+    uDMAControlBaseSet(systemDMAControlTable);
+    systemDMAEnabled = true;
+}
+
+void System::enablePeripheral(uint32_t periph)
+{
+    /*
+     * Enable a peripheral and wait until its registers can be accessed.
+     *
+     * periph: The peripheral (SYSCTL_PERIPH_...).
+     */
+
+    enablePeripherals(&periph, 1);
+}
+
+void System::enablePeripherals(const uint32_t *periphs, uint_fast8_t count)
+{
+    /*
+     * Enable several peripherals at once and wait until all of them are
+     * ready. They power up in parallel, so this is faster than enabling them
+     * one after the other. Instead of a fixed delay the ready flags are
+     * polled ("TivaWare(TM) Treiberbibliothek", SysCtlPeripheralReady).
+     *
+     * periphs: The peripherals (SYSCTL_PERIPH_...).
+     * count:   Number of peripherals.
+     */
+
+    for (uint_fast8_t i = 0; i < count; i++)
+    {
+        SysCtlPeripheralEnable(periphs[i]);
+    }
+#ifndef CFG_HOST_SIM
+    for (uint_fast8_t i = 0; i < count; i++)
+    {
+        while (!SysCtlPeripheralReady(periphs[i]));
+    }
+#endif
+}
+
+void System::markBoot(BootPhase phase)
+{
+    /*
+     * Record the end of a boot phase (see BootPhase). The application marks
+     * BootApplication and BootFirstCycle, System::init the others.
+     *
+     * phase: The phase which is complete.
+     */
+
+    systemBootUS[phase] = TimeBase::getUS();
+}
+
+uint32_t System::getBootUS(BootPhase phase)
+{
+    /*
+     * Returns the time from the reset to the end of the given boot phase in
+     * microseconds. Default is the time until the first control cycle.
+     *
+     * phase: The boot phase.
+     */
+
+    return systemBootUS[phase];
+}
+
+void System::reportBoot()
+{
+    /*
+     * Send the boot timing via the debug UART, once all phases are
+     * complete. Format (tab separated, microseconds since the reset):
+     *   BOOT\tStartup\t<us>\tClock\t<us>\tSystem\t<us>\tApplication\t<us>
+     *       \tFirstCycle\t<us>
+     * Note: Only sent with the DebugText format (see
+     *       System::getDebugFormat). Do not call it from an ISR.
+     */
+
+    if (systemDebugFormat != DebugText)
+    {
+        return;
+    }
+
+    // Large buffer, therefore not on the stack.
+    static TelemetryText text;
+    const char *labels[BootPhases] = {"\tStartup\t", "\tClock\t", "\tSystem\t",
+                                      "\tApplication\t", "\tFirstCycle\t"};
+
+    text.begin();
+    text.putString("BOOT");
+    for (uint_fast8_t i = 0; i < BootPhases; i++)
+    {
+        text.putString(labels[i]);
+        text.putInt(systemBootUS[i]);
+    }
+    text.endLine();
+
+    bool debugging = systemDebugEnabled;
+    setDebugging(false);
+    queueDebugTx(text.getData(), text.getLength(), true);
+    setDebugging(debugging);
+}
+
+void System::enableDebugDMA(void (*ISR)(void))
+{
+    /*
+     * Transmit the binary telemetry frames with the uDMA instead of writing
+     * them byte by byte into the UART FIFO. System::sendDebugVals then only
+     * copies the frames into a buffer and starts the transfer.
+     * Note: The uDMA signals the end of a transfer with the UART interrupt.
+     *       Like for the Timer class, a class method cannot be registered as
+     *       ISR, therefore the given function must call System::debugTxISR.
+     *       The UART interrupt must not preempt System::sendDebugVals (and
+     *       vice versa), see the priority plan in Config.h.
+     *
+     * ISR: Function calling System::debugTxISR.
+     */
+
+    initDMA();
+
+    // The TX FIFO requests data when it is half empty; the uDMA then writes
+    // 4 bytes at once ("TivaC Mikrocontroller Datenblatt", UART chapter,
+    // section "DMA Operation").
+    UARTFIFOLevelSet(UART0_BASE, UART_FIFO_TX4_8, UART_FIFO_RX4_8);
+
+    uDMAChannelAssign(UDMA_CH9_UART0TX);
+    uDMAChannelAttributeDisable(UDMA_CHANNEL_UART0TX, UDMA_ATTR_ALL);
+    uDMAChannelAttributeEnable(UDMA_CHANNEL_UART0TX, UDMA_ATTR_USEBURST);
+    uDMAChannelControlSet(UDMA_CHANNEL_UART0TX | UDMA_PRI_SELECT,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE
+                          | UDMA_ARB_4);
+    UARTDMAEnable(UART0_BASE, UART_DMA_TX);
+
+    UARTIntRegister(UART0_BASE, ISR);
+    IntEnable(INT_UART0);
+
+    systemTxDMA = true;
+}
+
+bool System::queueDebugTx(const void *data, uint32_t length, bool wait)
+{
+    /*
+     * Transmit data via the USB UART. With the uDMA (see
+     * System::enableDebugDMA) the data is copied into the transmit queue and
+     * this method returns immediately. If there is not enough space, the
+     * data is dropped and counted (see System::getDebugTxDropped), false is
+     * returned. Without the uDMA the data is written to the UART directly
+     * (blocking).
+     *
+     * data:   Pointer to the first byte.
+     * length: Number of bytes.
+     * wait:   Wait until there is enough space instead of dropping the data.
+     *         Only for the background loop (the queue is emptied by the
+     *         UART interrupt) and at most <systemTxBufferSize> bytes.
+     */
+
+    if (!systemTxDMA)
+    {
+        const uint8_t *bytes = (const uint8_t *) data;
+        for (uint32_t i = 0; i < length; i++)
+        {
+            UARTCharPut(UART0_BASE, bytes[i]);
+        }
+        return true;
+    }
+
+    if (wait && (length <= systemTxBufferSize))
+    {
+        // The buffer being filled is sent as soon as the current transfer is
+        // complete, so waiting for an idle UART always makes enough space.
+        while (systemTxBusy && (systemTxFillLength + length > systemTxBufferSize));
+    }
+
+    // The transfer complete interrupt swaps the buffers.
+    IntDisable(INT_UART0);
+
+    if (systemTxFillLength + length > systemTxBufferSize)
+    {
+        systemTxDropped++;
+        IntEnable(INT_UART0);
+        return false;
+    }
+
+    memcpy(&systemTxBuffers[systemTxFillBuffer][systemTxFillLength],
+           data, length);
+    systemTxFillLength += length;
+
+    if (!systemTxBusy && systemTxFillLength)
+    {
+        startDebugTx();
+    }
+
+    IntEnable(INT_UART0);
+    return true;
+}
+
+uint32_t System::getDebugTxSpace()
+{
+    /*
+     * Returns the number of bytes System::queueDebugTx accepts at the moment
+     * without waiting or dropping them. Without the uDMA the data is written
+     * to the UART directly, so there is no limit.
+     */
+
+    if (!systemTxDMA)
+    {
+        return UINT32_MAX;
+    }
+    return systemTxBufferSize - systemTxFillLength;
+}
+
+uint32_t System::getDebugTxDropped()
+{
+    /*
+     * Returns the number of transmissions dropped because the transmit queue
+     * was full.
+     */
+
+    return systemTxDropped;
+}
+
+void System::debugTxISR()
+{
+    /*
+     * Must be called by the UART interrupt (see System::enableDebugDMA).
+     * Starts the transfer of the next buffer once the current one is done.
+     */
+
+    // Clear all UART interrupts and the uDMA completion flag, which is not
+    // cleared automatically for peripheral channels ("TivaC Mikrocontroller
+    // Datenblatt", uDMA chapter).
+    UARTIntClear(UART0_BASE, UARTIntStatus(UART0_BASE, true));
+    uDMAIntClear(1 << UDMA_CHANNEL_UART0TX);
+
+    if (systemTxBusy
+        && (uDMAChannelModeGet(UDMA_CHANNEL_UART0TX | UDMA_PRI_SELECT)
+            == UDMA_MODE_STOP))
+    {
+        systemTxBusy = false;
+        if (systemTxFillLength)
+        {
+            startDebugTx();
+        }
+    }
+}
+
+void System::flushDebugTx()
+{
+    /*
+     * Wait until all queued data has been written to the UART FIFO.
+     * Note: Do not call this from an ISR with a priority higher or equal to
+     *       the UART interrupt.
+     */
+
+    while (systemTxBusy);
+}
+
+void System::benchmarkDebugText(uint32_t &formatterCycles,
+                                uint32_t &printfCycles)
+{
+    /*
+     * Measure the CPU cycles needed to send the current debug values as text
+     * line, once with TelemetryText (without the transmission, which is done
+     * by the uDMA) and once with UARTprintf as it was done before. The
+     * UARTprintf line is sent (prefixed by "PROF\tPrintf_Line\t"), its time
+     * includes waiting for the UART FIFO, just like in the debug ISR.
+     * Note: Call with debugging disabled (see System::setDebugging), f.ex.
+     *       inside Profiler::sendReport.
+     *
+     * formatterCycles: Cycles needed by TelemetryText.
+     * printfCycles:    Cycles needed by UARTprintf.
+     */
+
+    formatterCycles = 0;
+    printfCycles = 0;
+    if (!takeDebugSnapshot())
+    {
+        return;
+    }
+    DebugSnapshot &snap = systemDebugSnapshot;
+
+    uint32_t start = CycleCounter::get();
+    renderDebugValues();
+    formatterCycles = CycleCounter::get() - start;
+
+    UARTprintf("PROF\tPrintf_Line\t");
+    start = CycleCounter::get();
+    for (uint_fast8_t i = 0; i < snap.count; i++)
+    {
+        if (snap.enabled[i / 32] & (1 << (i % 32)))
+        {
+            UARTprintf("%04d\t", (snap.types[i] == DebugFloat)
+                                 ? (int32_t) snap.vals[i].f : snap.vals[i].i);
         }
-        UARTprintf("\n");
-        
     }
+    UARTprintf("\n");
+    printfCycles = CycleCounter::get() - start;
+}
+
+void System::startDebugTx()
+{
+    /*
+     * Transmit the buffer being filled and use the other one for new data.
+     * Note: Must only be called if no transfer is running and with the UART
+     *       interrupt disabled (or from inside it).
+     */
+
+    uDMAChannelTransferSet(UDMA_CHANNEL_UART0TX | UDMA_PRI_SELECT,
+                           UDMA_MODE_BASIC,
+                           systemTxBuffers[systemTxFillBuffer],
+                           (void *) (UART0_BASE + UART_O_DR),
+                           systemTxFillLength);
+    systemTxBusy = true;
+    uDMAChannelEnable(UDMA_CHANNEL_UART0TX);
+
+    systemTxFillBuffer ^= 1;
+    systemTxFillLength = 0;
 }
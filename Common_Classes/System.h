@@ -20,6 +20,7 @@
  *                          device. This includes defines such as peripheral
  *                          base address locations such as GPIO_PORTF_BASE.
  * inc/hw_gpio.h:           Defines for the GPIO register offsets.
+ * inc/hw_nvic.h:           Defines for the NVIC registers (fault status).
  * driverlib/pin_map.h:     Mapping of peripherals to pins for all parts.
  * driverlib/sysctl.h:      Defines and macros for the System Control API of
  *                          DriverLib. This includes API functions such as
@@ -27,117 +28,388 @@
  * driverlib/interrupt.h:   Defines and macros for NVIC Controller (Interrupt)
  *                          API of driverLib. This includes API functions such
  *                          as IntEnable and IntPrioritySet.
+ * inc/hw_ints.h:           Macros that define the interrupt assignment on
+ *                          Tiva C Series MCUs (f.ex. INT_TIMER0A).
  * driverlib/fpu.h:         Prototypes for the floating point manipulation
  *                          routines.
  * driverlib/gpio.h:        Defines and macros for GPIO API of DriverLib. This
  *                          includes API functions such as GPIOPinWrite.
+ * driverlib/uart.h:        Defines and macros for the UART API of DriverLib.
+ *                          Used for the binary telemetry.
+ * driverlib/udma.h:        Defines and macros for the uDMA API of DriverLib.
+ * inc/hw_uart.h:           Defines for the UART register offsets (data
+ *                          register as DMA destination).
+ * string.h:                memcpy for the transmit queue.
  * uartstdio.h:             Utility driver to provide simple UART console
  *                          functions.
  * ErrorCodes.h:            Enum with error codes for the error method.
+ * CycleCounter.h:          Durations (f.ex. System::benchmarkDebugText).
+ * TelemetryFrame.h:        Frames of the binary telemetry protocol.
+ * TelemetryText.h:         Fast formatting of the text telemetry.
+ * TimeBase.h:              Microsecond time base for the delays.
+ * Config.h:                CFG_RAMFUNC_ENABLE for RAMFUNC.
+ * BlackBox.h:              Crash-persistent record of the last error.
+ * atomic:                  (Host only) memory barrier of the host system.
  */
 #include <stdbool.h>
 #include <stdint.h>
 #include "inc/hw_types.h"
 #include "inc/hw_memmap.h"
 #include "inc/hw_gpio.h"
+#include "inc/hw_nvic.h"
 #include "driverlib/pin_map.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/interrupt.h"
+#include "inc/hw_ints.h"
 #include "driverlib/fpu.h"
 #include "driverlib/gpio.h"
+#include "driverlib/uart.h"
+#include "driverlib/udma.h"
+#include "inc/hw_uart.h"
+#include <string.h>
 #include "uartstdio.h"
 #include "ErrorCodes.h"
+#include "CycleCounter.h"
+#include "TelemetryFrame.h"
+#include "TelemetryText.h"
+#include "BlackBox.h"
+#include "TimeBase.h"
+#include "Config.h"
+#ifdef CFG_HOST_SIM
+#include <atomic>
+#endif
+
+
+/*
+ * Functions marked with RAMFUNC are executed from the SRAM, where the CPU
+ * fetches instructions without the flash wait states (above 40MHz). The
+ * compiler places them in the section .TI.ramfunc, which the startup code
+ * copies from the flash to the SRAM (see tm4c123gh6pm.cmd). Only used for the
+ * control ISR path, as the SRAM is small. Disabled by CFG_RAMFUNC_ENABLE in
+ * Config.h and on the host.
+ */
+#if defined(CFG_RAMFUNC_ENABLE) && defined(__TI_ARM__)
+#define RAMFUNC __attribute__((ramfunc))
+#else
+#define RAMFUNC
+#endif
+
+
+/*
+ * Handle of a debug value (index into the channel table of the System class).
+ * See System::registerDebugVal.
+ */
+typedef uint8_t DebugHandle;
+
+/*
+ * Data type of a debug value. It determines how the value is transmitted in
+ * the binary format (int16 values are saturated). In the text format float
+ * values are sent with a fixed number of decimals (see
+ * System::setDebugValDecimals).
+ */
+enum DebugType {DebugInt16, DebugInt32, DebugFloat};
+
+/*
+ * Transmission format of the debug values (see System::sendDebugVals):
+ * DebugText:   Tab separated lines for the Arduino serial plotter.
+ * DebugBinary: COBS framed binary telemetry for Tools/telemetry_decode.py.
+ * DebugCompressed: Binary telemetry, but values are sent as differences to
+ *              the previous frame (zigzag varints) with periodic keyframes.
+ */
+enum DebugFormat {DebugText, DebugBinary, DebugCompressed};
+
+/*
+ * Phases of the boot, each ends at the given point (see System::markBoot):
+ * BootStartup:     Entry of System::init (C initialization and global
+ *                  constructors done).
+ * BootClock:       PLL locked.
+ * BootSystem:      End of System::init.
+ * BootApplication: Application initialized, about to start the timers.
+ * BootFirstCycle:  Start of the first control cycle.
+ */
+enum BootPhase {BootStartup, BootClock, BootSystem, BootApplication,
+                BootFirstCycle, BootPhases};
+
+// Storage of a debug value. The type of the channel selects the member.
+union DebugValue
+{
+    int32_t i;
+    float   f;
+};
 
 
 class System
 {
 public:
     System();
-    virtual ~System();
-    void init(uint32_t clk);
+    ~System();
+    void init(uint32_t clk, uint32_t baud = 115200);
+    void initDMA();
+    void enablePeripheral(uint32_t periph);
+    void enablePeripherals(const uint32_t *periphs, uint_fast8_t count);
+    void markBoot(BootPhase phase);
+    uint32_t getBootUS(BootPhase phase = BootFirstCycle);
+    void reportBoot();
     void error(ErrorCodes ErrorCode = UnknownError,
                void *faultOrigin0 = 0,
                void *faultOrigin1 = 0,
                void *faultOrigin2 = 0);
+    void registerSafeOutput(uint32_t portBase, uint8_t pins,
+                            uint8_t inactiveLevel);
+    void setErrorRecoverable(ErrorCodes errorCode, bool recoverable = true);
+    static void cpuFault(uint32_t *frame);
     void enableFPU();
+    uint32_t setClockFreq(uint32_t clk);
+    void deepSleep(uint32_t wakeInt0, uint32_t wakeInt1 = 0);
+    uint32_t getGPIOPeriph(uint32_t portBase);
     uint32_t getClockFreq();
     uint32_t getPWMClockDiv();
     void delayCycles(uint32_t cycles);
-    void delayUS(uint32_t us);
+    void delayUS(uint64_t us);
+    void setIntPriority(uint32_t interrupt, uint32_t preempt,
+                        uint32_t sub = 0);
+    uint32_t enterCritical(uint32_t preempt = 1);
+    void exitCritical(uint32_t state);
     void setDebugging(bool debug);
+    bool getDebugging();
+    void setDebugFormat(DebugFormat format);
+    DebugFormat getDebugFormat();
+    void beginDebugUpdate();
+    void endDebugUpdate();
+    DebugHandle registerDebugVal(const char* name,
+                                 DebugType type = DebugInt32);
+    void setDebugValEnabled(DebugHandle handle, bool enabled);
+    void setDebugValDecimals(DebugHandle handle, uint_fast8_t decimals);
     void setDebugVal(const char* name, int32_t value);
     void sendDebugVals();
+    void enableDebugDMA(void (*ISR)(void));
+    bool queueDebugTx(const void *data, uint32_t length, bool wait = false);
+    uint32_t getDebugTxSpace();
+    uint32_t getDebugTxDropped();
+    void debugTxISR();
+    void flushDebugTx();
+    void benchmarkDebugText(uint32_t &formatterCycles, uint32_t &printfCycles);
+
+    inline void setDebugVal(DebugHandle handle, int32_t value)
+    {
+        /*
+         * Update a debug value registered with System::registerDebugVal.
+         * This is a single store and can therefore be used in time critical
+         * code as often as needed.
+         *
+         * handle: The handle returned by System::registerDebugVal.
+         * value:  Integer value to transmit.
+         */
+
+        systemDebugVals[handle].i = value;
+    }
+
+    inline void setDebugValFloat(DebugHandle handle, float value)
+    {
+        /*
+         * Same as System::setDebugVal, but for channels registered with
+         * DebugFloat. The value is transmitted without loss in the binary
+         * format.
+         * Note: This is a separate method because the compiler would silently
+         *       pick a float overload for all the float expressions passed to
+         *       integer channels.
+         *
+         * handle: The handle returned by System::registerDebugVal.
+         * value:  Float value to transmit.
+         */
+
+        systemDebugVals[handle].f = value;
+    }
+
+    static inline void memoryBarrier()
+    {
+        /*
+         * Data memory barrier. Prevents both the compiler and the CPU from
+         * reordering memory accesses across this point. Needed whenever
+         * data is shared between ISRs and other code without disabling
+         * interrupts.
+         */
+#if defined(CFG_HOST_SIM)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+#elif defined(__TI_ARM__)
+        __asm(" dmb");
+#else
+        __asm volatile ("dmb" ::: "memory");
+#endif
+    }
 
 private:
+    bool setPLL(uint32_t clk);
+    uint32_t drainDebugTx();
+    void enterSafeState();
+    static bool isSafeToRead(const void *address, uint32_t length);
+    bool takeDebugSnapshot();
+    void sendDebugText();
+    void renderDebugValues();
+    void sendDebugBinary();
+    void sendDebugFrame();
+    void startDebugTx();
+
     bool systemDebugEnabled = true;
-    bool systemDebugNewLabel = false;
-    const static uint32_t systemMaxDebugVals = 8;
-    const char systemDebugUnused[1] = "";
-    int32_t systemDebugVals[systemMaxDebugVals];
-    const char* systemDebugNames[systemMaxDebugVals] = {systemDebugUnused,
-                                                        systemDebugUnused,
-                                                        systemDebugUnused,
-                                                        systemDebugUnused,
-                                                        systemDebugUnused,
-                                                        systemDebugUnused,
-                                                        systemDebugUnused,
-                                                        systemDebugUnused};
+    DebugFormat systemDebugFormat = DebugText;
+    /*
+     * Number of label changes and requests to send the labels again (written
+     * by the background, f.ex. System::registerDebugVal and
+     * System::setDebugging) and number of label changes already transmitted
+     * (written by System::sendDebugVals only). Labels are sent if they
+     * differ. Using two counters instead of one flag ensures each variable
+     * has only one writer, so no request gets lost.
+     */
+    uint32_t systemDebugLabels = 0;
+    uint32_t systemDebugSentLabels = 0;
+    /*
+     * Channel table. A channel is registered once and identified by its
+     * index (DebugHandle) afterwards. The additional last value is used for
+     * all channels which did not fit into the table; it is never sent.
+     * Only channels whose bit is set in systemDebugEnabledMask are sent.
+     */
+    const static uint32_t systemMaxDebugVals = 32;
+    const static uint32_t systemDebugMaskWords = (systemMaxDebugVals + 31) / 32;
+    uint32_t systemDebugCount = 0;
+    DebugValue systemDebugVals[systemMaxDebugVals + 1];
+    const char* systemDebugNames[systemMaxDebugVals];
+    uint8_t systemDebugTypes[systemMaxDebugVals];
+    uint8_t systemDebugDecimals[systemMaxDebugVals];
+    uint32_t systemDebugEnabledMask[systemDebugMaskWords] = {0};
     bool systemTooManyDebugVals = false;
 
+    /*
+     * Sequence lock for the debug values. It is odd while the control ISR
+     * updates the values (between System::beginDebugUpdate and
+     * System::endDebugUpdate) and incremented twice per update. The reader
+     * (System::sendDebugVals) retries its copy if the sequence was odd or
+     * changed meanwhile.
+     */
+    volatile uint32_t systemDebugSeq = 0;
+    const static uint32_t systemDebugMaxRetries = 4;
+
+    // Microseconds since the reset (TimeBase, lowest 32 bits) at the last
+    // System::beginDebugUpdate.
+    volatile uint32_t systemDebugTimestamp = 0;
+
+    /*
+     * Consistent copy of the channel table, only used by the reader.
+     * Note: This and the other buffers of the debug output are static so
+     *       that they are not placed on the (small) stack if a System
+     *       object is a local variable, as in the test programs. There is
+     *       only one System object anyway.
+     */
+    struct DebugSnapshot
+    {
+        uint32_t count, labels, timestamp;
+        bool tooMany;
+        DebugValue vals[systemMaxDebugVals];
+        const char* names[systemMaxDebugVals];
+        uint8_t types[systemMaxDebugVals];
+        uint8_t decimals[systemMaxDebugVals];
+        uint32_t enabled[systemDebugMaskWords];
+    };
+    static DebugSnapshot systemDebugSnapshot;
+
+    // Text format: Line buffer and default decimals of float values.
+    static TelemetryText systemDebugText;
+    const static uint_fast8_t systemDebugDefaultDecimals = 2;
+
+    /*
+     * Binary format. The frame counter allows the host to detect lost
+     * frames. The timestamps come from the time base, so they keep
+     * counting while the core sleeps and across clock changes. The channel
+     * descriptions are repeated periodically so that a host can attach at
+     * any time.
+     */
+    static TelemetryFrame systemDebugFrame;
+    uint16_t systemDebugFrameCount = 0;
+    uint32_t systemDebugFramesSinceDescr = 0;
+    const static uint32_t systemDebugDescrPeriod = 64;
+
+    /*
+     * Compressed format. The previous values are stored as sent (int16
+     * channels saturated). A keyframe is sent at least every
+     * <systemDebugKeyPeriod> data frames.
+     */
+    uint32_t systemDebugPrevVals[systemMaxDebugVals];
+    uint32_t systemDebugLastFrameTime = 0;
+    uint32_t systemDebugFramesSinceKey = 0;
+    const static uint32_t systemDebugKeyPeriod = 16;
+    const static uint32_t systemDebugMaxNameLength = 64;
+
+    /*
+     * uDMA channel control table, shared by all classes using the uDMA (see
+     * System::initDMA). It must be aligned to 1024 bytes.
+     */
+    static uint8_t systemDMAControlTable[1024];
+    bool systemDMAEnabled = false;
+
+    /*
+     * Double buffered transmit queue of the USB UART. The uDMA transmits one
+     * buffer while new data is appended to the other one. When the transfer
+     * is complete (System::debugTxISR) the buffers are swapped.
+     * The uDMA can transfer at most 1024 items at once.
+     */
+    const static uint32_t systemTxBufferSize = 512;
+    static uint8_t systemTxBuffers[2][systemTxBufferSize];
+    uint_fast8_t systemTxFillBuffer = 0;
+    uint32_t systemTxFillLength = 0;
+    volatile bool systemTxBusy = false;
+    bool systemTxDMA = false;
+    uint32_t systemTxDropped = 0;
+
     uint32_t systemClockFrequency = 0;
     uint32_t systemPWMClockDiv = 0;
+    uint32_t systemBaud = 0;
+
+    // End of each boot phase in microseconds since the reset.
+    uint32_t systemBootUS[BootPhases] = {};
+
+    // Instance handling the CPU faults (see System::cpuFault).
+    static System *systemActive;
+
+    /*
+     * Outputs forced into their inactive state first by System::error (f.ex.
+     * the motors). Their GPIO ports are not reset afterwards.
+     */
+    struct SafeOutput
+    {
+        uint32_t portBase;
+        uint32_t periph;
+        uint8_t pins;
+        uint8_t level;
+    };
+    const static uint_fast8_t systemMaxSafeOutputs = 4;
+    SafeOutput systemSafeOutputs[systemMaxSafeOutputs];
+    uint_fast8_t systemSafeOutputCount = 0;
+    // GPIO ports and their peripherals (static, stays in the flash).
+    static constexpr uint32_t systemGPIOPorts[6][2] =
+                        {{GPIO_PORTA_BASE, SYSCTL_PERIPH_GPIOA},
+                         {GPIO_PORTB_BASE, SYSCTL_PERIPH_GPIOB},
+                         {GPIO_PORTC_BASE, SYSCTL_PERIPH_GPIOC},
+                         {GPIO_PORTD_BASE, SYSCTL_PERIPH_GPIOD},
+                         {GPIO_PORTE_BASE, SYSCTL_PERIPH_GPIOE},
+                         {GPIO_PORTF_BASE, SYSCTL_PERIPH_GPIOF}};
+
+    /*
+     * Errors after which System::error restarts the uC (bit n: ErrorCodes
+     * value n), at most <systemMaxRestarts> times in a row.
+     */
+    uint32_t systemRecoverableErrors = 0;
+    const static uint32_t systemMaxRestarts = 3;
+
+    /*
+     * The NVIC of the TM4C123 implements 3 priority bits. 2 of them are used
+     * for the preemption priority (0-3), 1 for the subpriority (0-1).
+     */
+    const static uint32_t systemIntPrioBits = 3;
+    const static uint32_t systemIntPreemptBits = 2;
 
-    // All peripherals of the uC
-    const uint_fast8_t systemPeripheralsCount = 49;
-    const uint32_t systemPeripherals[49] = {SYSCTL_PERIPH_WDOG0,
-                                            SYSCTL_PERIPH_WDOG1,
-                                            SYSCTL_PERIPH_TIMER0,
-                                            SYSCTL_PERIPH_TIMER1,
-                                            SYSCTL_PERIPH_TIMER2,
-                                            SYSCTL_PERIPH_TIMER3,
-                                            SYSCTL_PERIPH_TIMER4,
-                                            SYSCTL_PERIPH_TIMER5,
-                                            SYSCTL_PERIPH_GPIOA,
-                                            SYSCTL_PERIPH_GPIOB,
-                                            SYSCTL_PERIPH_GPIOC,
-                                            SYSCTL_PERIPH_GPIOD,
-                                            SYSCTL_PERIPH_GPIOE,
-                                            SYSCTL_PERIPH_GPIOF,
-                                            SYSCTL_PERIPH_UDMA,
-                                            SYSCTL_PERIPH_HIBERNATE,
-                                            SYSCTL_PERIPH_UART0,
-                                            SYSCTL_PERIPH_UART1,
-                                            SYSCTL_PERIPH_UART2,
-                                            SYSCTL_PERIPH_UART3,
-                                            SYSCTL_PERIPH_UART4,
-                                            SYSCTL_PERIPH_UART5,
-                                            SYSCTL_PERIPH_UART6,
-                                            SYSCTL_PERIPH_UART7,
-                                            SYSCTL_PERIPH_SSI0,
-                                            SYSCTL_PERIPH_SSI1,
-                                            SYSCTL_PERIPH_SSI2,
-                                            SYSCTL_PERIPH_SSI3,
-                                            SYSCTL_PERIPH_I2C0,
-                                            SYSCTL_PERIPH_I2C1,
-                                            SYSCTL_PERIPH_I2C2,
-                                            SYSCTL_PERIPH_I2C3,
-                                            SYSCTL_PERIPH_USB0,
-                                            SYSCTL_PERIPH_CAN0,
-                                            SYSCTL_PERIPH_CAN1,
-                                            SYSCTL_PERIPH_ADC0,
-                                            SYSCTL_PERIPH_ADC1,
-                                            SYSCTL_PERIPH_COMP0,
-                                            SYSCTL_PERIPH_PWM0,
-                                            SYSCTL_PERIPH_PWM1,
-                                            SYSCTL_PERIPH_QEI0,
-                                            SYSCTL_PERIPH_QEI1,
-                                            SYSCTL_PERIPH_EEPROM0,
-                                            SYSCTL_PERIPH_WTIMER0,
-                                            SYSCTL_PERIPH_WTIMER1,
-                                            SYSCTL_PERIPH_WTIMER2,
-                                            SYSCTL_PERIPH_WTIMER3,
-                                            SYSCTL_PERIPH_WTIMER4,
-                                            SYSCTL_PERIPH_WTIMER5};
+    // All peripherals of the uC. Static, so it is not copied into every
+    // object at construction but stays in the flash.
+    const static uint_fast8_t systemPeripheralsCount = 49;
+    const static uint32_t systemPeripherals[49];
 };
 
 
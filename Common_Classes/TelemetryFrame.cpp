@@ -0,0 +1,213 @@
+/*
+ * TelemetryFrame.cpp
+ *
+ *    Author:
+ *     Email:
+ *
+ * Builder for the frames of the binary telemetry protocol.
+ */
+
+#include "TelemetryFrame.h"
+
+
+const uint16_t TelemetryFrame::tfCRCTable[16] = {0x0000, 0x1021, 0x2042, 0x3063,
+                                                 0x4084, 0x50a5, 0x60c6, 0x70e7,
+                                                 0x8108, 0x9129, 0xa14a, 0xb16b,
+                                                 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef};
+
+
+TelemetryFrame::TelemetryFrame()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+TelemetryFrame::~TelemetryFrame()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+void TelemetryFrame::begin(uint8_t type)
+{
+    /*
+     * Discard the previous frame and start a new one.
+     *
+     * type: Frame type (TELEMETRY_FRAME_...).
+     */
+
+    tfRawLength = 0;
+    tfEncodedLength = 0;
+    tfOverflow = false;
+    putU8(type);
+}
+
+void TelemetryFrame::putU8(uint8_t value)
+{
+    /*
+     * Append one byte to the frame. Two bytes are reserved for the CRC. If
+     * the frame is full, the frame is marked as invalid (see
+     * TelemetryFrame::finish).
+     *
+     * value: Byte to append.
+     */
+
+    if (tfRawLength >= tfMaxRaw - 2)
+    {
+        tfOverflow = true;
+        return;
+    }
+    tfRaw[tfRawLength++] = value;
+}
+
+void TelemetryFrame::putU16(uint16_t value)
+{
+    /*
+     * Append a 16 bit value (little endian).
+     *
+     * value: Value to append. Signed values can be passed after casting.
+     */
+
+    putU8(value);
+    putU8(value >> 8);
+}
+
+void TelemetryFrame::putU32(uint32_t value)
+{
+    /*
+     * Append a 32 bit value (little endian).
+     *
+     * value: Value to append. Signed values can be passed after casting.
+     */
+
+    putU16(value);
+    putU16(value >> 16);
+}
+
+void TelemetryFrame::putBytes(const void *data, uint32_t length)
+{
+    /*
+     * Append a sequence of bytes.
+     *
+     * data:   Pointer to the first byte.
+     * length: Number of bytes.
+     */
+
+    const uint8_t *bytes = (const uint8_t *) data;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        putU8(bytes[i]);
+    }
+}
+
+void TelemetryFrame::putVarint(uint32_t value)
+{
+    /*
+     * Append a value as varint: 7 bits per byte, least significant group
+     * first, the highest bit marks that another byte follows. Values below
+     * 128 need one byte, a 32 bit value needs at most TELEMETRY_VARINT_MAX
+     * bytes. Use TelemetryFrame::zigzag for signed values.
+     *
+     * value: Value to append.
+     */
+
+    while (value >= 0x80)
+    {
+        putU8(value | 0x80);
+        value >>= 7;
+    }
+    putU8(value);
+}
+
+uint32_t TelemetryFrame::finish()
+{
+    /*
+     * Append the CRC, COBS encode the frame and terminate it with a zero
+     * byte. Returns the length of the encoded frame (see
+     * TelemetryFrame::getData) or 0 if the frame did not fit into the buffer.
+     */
+
+    if (tfOverflow)
+    {
+        tfEncodedLength = 0;
+        return 0;
+    }
+
+    // Space for the CRC is reserved by putU8.
+    uint16_t checksum = crc(tfRaw, tfRawLength);
+    tfRaw[tfRawLength++] = checksum;
+    tfRaw[tfRawLength++] = checksum >> 8;
+
+    /*
+     * COBS: Each block starts with a code byte giving the distance to the
+     * next zero byte (which is omitted). A code of 0xff marks a block of 254
+     * non-zero bytes which is not followed by a zero.
+     */
+    uint32_t write = 1;
+    uint32_t codeIndex = 0;
+    uint8_t code = 1;
+    for (uint32_t read = 0; read < tfRawLength; read++)
+    {
+        if (tfRaw[read] == 0)
+        {
+            tfEncoded[codeIndex] = code;
+            codeIndex = write++;
+            code = 1;
+        }
+        else
+        {
+            tfEncoded[write++] = tfRaw[read];
+            code++;
+            if (code == 0xff)
+            {
+                tfEncoded[codeIndex] = code;
+                codeIndex = write++;
+                code = 1;
+            }
+        }
+    }
+    tfEncoded[codeIndex] = code;
+    tfEncoded[write++] = 0;
+
+    tfEncodedLength = write;
+    return tfEncodedLength;
+}
+
+const uint8_t* TelemetryFrame::getData()
+{
+    /*
+     * Returns the encoded frame (valid after TelemetryFrame::finish).
+     */
+
+    return tfEncoded;
+}
+
+uint32_t TelemetryFrame::getLength()
+{
+    /*
+     * Returns the length of the encoded frame including the delimiter.
+     */
+
+    return tfEncodedLength;
+}
+
+uint16_t TelemetryFrame::crc(const uint8_t *data, uint32_t length)
+{
+    /*
+     * CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xffff, no
+     * reflection, no final XOR).
+     *
+     * data:   Pointer to the first byte.
+     * length: Number of bytes.
+     */
+
+    uint16_t checksum = 0xffff;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        checksum = (checksum << 4) ^ tfCRCTable[(checksum >> 12) ^ (data[i] >> 4)];
+        checksum = (checksum << 4) ^ tfCRCTable[(checksum >> 12) ^ (data[i] & 0x0f)];
+    }
+    return checksum;
+}
@@ -0,0 +1,89 @@
+/*
+ * TelemetryFrame.h
+ *
+ *    Author:
+ *     Email:
+ *
+ * Builder for the frames of the binary telemetry protocol (see
+ * System::sendDebugVals and Tools/telemetry_decode.py).
+ * A frame is assembled byte by byte (little endian), then a CRC-16 is
+ * appended and the whole frame is COBS encoded ("Consistent Overhead Byte
+ * Stuffing", Cheshire and Baker, 1999). COBS removes all zero bytes from the
+ * frame, so a single zero byte can terminate it. The receiver can therefore
+ * resynchronize at any point of the stream and no escaping is needed.
+ *
+ * Frame (before COBS):
+ *   uint8_t  type
+ *   ...      payload, depending on the type
+ *   uint16_t CRC-16/CCITT-FALSE of type and payload
+ */
+
+#ifndef TELEMETRYFRAME_H_
+#define TELEMETRYFRAME_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// Frame types
+#define TELEMETRY_FRAME_DATA        0x01    // Values of all enabled channels
+#define TELEMETRY_FRAME_CHANNEL     0x02    // Description of one channel
+#define TELEMETRY_FRAME_DELTA       0x03    // Values relative to the previous frame
+#define TELEMETRY_FRAME_RECORD      0x04    // One control cycle (Segway::logRecord)
+
+// Maximum length of a varint (see TelemetryFrame::putVarint)
+#define TELEMETRY_VARINT_MAX        5
+
+
+class TelemetryFrame
+{
+public:
+    TelemetryFrame();
+    ~TelemetryFrame();
+    void begin(uint8_t type);
+    void putU8(uint8_t value);
+    void putU16(uint16_t value);
+    void putU32(uint32_t value);
+    void putBytes(const void *data, uint32_t length);
+    void putVarint(uint32_t value);
+    uint32_t finish();
+    const uint8_t* getData();
+    uint32_t getLength();
+
+    static inline uint32_t zigzag(int32_t value)
+    {
+        /*
+         * Map signed to unsigned values so that small magnitudes give small
+         * results: 0, -1, 1, -2, 2, ... become 0, 1, 2, 3, 4, ...
+         *
+         * value: Signed value, f.ex. the difference of two samples.
+         */
+
+        return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+    }
+
+private:
+    uint16_t crc(const uint8_t *data, uint32_t length);
+
+    /*
+     * Raw frame including CRC and the encoded frame including the delimiter.
+     * COBS adds one byte per started block of 254 bytes.
+     */
+    const static uint32_t tfMaxRaw = 192;
+    const static uint32_t tfMaxEncoded = tfMaxRaw + tfMaxRaw / 254 + 2;
+    uint8_t tfRaw[tfMaxRaw];
+    uint8_t tfEncoded[tfMaxEncoded];
+    uint32_t tfRawLength = 0;
+    uint32_t tfEncodedLength = 0;
+    bool tfOverflow = false;
+
+    // CRC-16/CCITT-FALSE, processed one nibble at a time (32 byte table).
+    static const uint16_t tfCRCTable[16];
+};
+
+#endif /* TELEMETRYFRAME_H_ */
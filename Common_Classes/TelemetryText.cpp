@@ -0,0 +1,245 @@
+/*
+ * TelemetryText.cpp
+ *
+ *    Author:
+ *     Email:
+ *
+ * Renders a text line of the debug values into a buffer.
+ */
+
+#include "TelemetryText.h"
+
+
+const char TelemetryText::ttDigitPairs[200] = {
+        '0','0', '0','1', '0','2', '0','3', '0','4', '0','5', '0','6', '0','7', '0','8', '0','9',
+        '1','0', '1','1', '1','2', '1','3', '1','4', '1','5', '1','6', '1','7', '1','8', '1','9',
+        '2','0', '2','1', '2','2', '2','3', '2','4', '2','5', '2','6', '2','7', '2','8', '2','9',
+        '3','0', '3','1', '3','2', '3','3', '3','4', '3','5', '3','6', '3','7', '3','8', '3','9',
+        '4','0', '4','1', '4','2', '4','3', '4','4', '4','5', '4','6', '4','7', '4','8', '4','9',
+        '5','0', '5','1', '5','2', '5','3', '5','4', '5','5', '5','6', '5','7', '5','8', '5','9',
+        '6','0', '6','1', '6','2', '6','3', '6','4', '6','5', '6','6', '6','7', '6','8', '6','9',
+        '7','0', '7','1', '7','2', '7','3', '7','4', '7','5', '7','6', '7','7', '7','8', '7','9',
+        '8','0', '8','1', '8','2', '8','3', '8','4', '8','5', '8','6', '8','7', '8','8', '8','9',
+        '9','0', '9','1', '9','2', '9','3', '9','4', '9','5', '9','6', '9','7', '9','8', '9','9'};
+
+const uint32_t TelemetryText::ttPowersOf10[ttMaxDecimals + 1] = {1, 10, 100, 1000,
+                                                                  10000, 100000,
+                                                                  1000000};
+
+
+TelemetryText::TelemetryText()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+TelemetryText::~TelemetryText()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+void TelemetryText::begin()
+{
+    /*
+     * Discard the previous line and start a new one.
+     */
+
+    ttLength = 0;
+    ttOverflow = false;
+}
+
+void TelemetryText::putChar(char c)
+{
+    /*
+     * Append one character. If the buffer is full the character is dropped
+     * and the line is marked as truncated (see TelemetryText::overflowed).
+     *
+     * c: Character to append.
+     */
+
+    if (ttLength >= ttMaxLength - 2)
+    {
+        ttOverflow = true;
+        return;
+    }
+    ttBuffer[ttLength++] = c;
+}
+
+void TelemetryText::putString(const char *str)
+{
+    /*
+     * Append a zero terminated string (without the terminating zero).
+     *
+     * str: The string to append.
+     */
+
+    while (*str)
+    {
+        putChar(*str++);
+    }
+}
+
+void TelemetryText::putInt(int32_t value, uint_fast8_t width)
+{
+    /*
+     * Append a decimal integer. Same result as UARTprintf("%0<width>d").
+     *
+     * value: Integer to append.
+     * width: Minimum number of characters including the sign. Missing digits
+     *        are filled with leading zeros.
+     */
+
+    if (value < 0)
+    {
+        putChar('-');
+        // Unsigned negation also works for INT32_MIN.
+        putUInt(-(uint32_t) value, width ? width - 1 : 0);
+    }
+    else
+    {
+        putUInt(value, width);
+    }
+}
+
+void TelemetryText::putFixed(float value, uint_fast8_t decimals)
+{
+    /*
+     * Append a float value with a fixed number of decimals (rounded), f.ex.
+     * "-12.50" for -12.5 and 2 decimals. Values too large for the given
+     * number of decimals are saturated.
+     *
+     * value:    Float value to append.
+     * decimals: Number of decimals (0 - 6).
+     */
+
+    if (decimals > ttMaxDecimals)
+    {
+        decimals = ttMaxDecimals;
+    }
+
+    bool negative = (value < 0.0f);
+    if (negative)
+    {
+        value = -value;
+    }
+
+    // Rounded value in units of the last decimal.
+    float scaled = value * ttPowersOf10[decimals] + 0.5f;
+    uint32_t fixed = 0xffffffff;
+    if (scaled < 4294967040.0f)
+    {
+        fixed = scaled;
+    }
+
+    // No sign if it rounds to 0.
+    if (negative && fixed)
+    {
+        putChar('-');
+    }
+    putUInt(fixed / ttPowersOf10[decimals], 0);
+    if (decimals)
+    {
+        putChar('.');
+        putUInt(fixed % ttPowersOf10[decimals], decimals);
+    }
+}
+
+void TelemetryText::putHex(uint32_t value)
+{
+    /*
+     * Append a 32 bit value as 8 hexadecimal digits with a "0x" prefix, f.ex.
+     * for addresses.
+     *
+     * value: Value to append.
+     */
+
+    putChar('0');
+    putChar('x');
+    for (int_fast8_t shift = 28; shift >= 0; shift -= 4)
+    {
+        putChar("0123456789abcdef"[(value >> shift) & 0xf]);
+    }
+}
+
+void TelemetryText::endLine()
+{
+    /*
+     * Terminate the line with "\r\n" like uartstdio does. Space for it is
+     * always reserved.
+     */
+
+    ttBuffer[ttLength++] = '\r';
+    ttBuffer[ttLength++] = '\n';
+}
+
+const char* TelemetryText::getData()
+{
+    /*
+     * Returns the rendered line (not zero terminated, see
+     * TelemetryText::getLength).
+     */
+
+    return ttBuffer;
+}
+
+uint32_t TelemetryText::getLength()
+{
+    /*
+     * Returns the length of the rendered line.
+     */
+
+    return ttLength;
+}
+
+bool TelemetryText::overflowed()
+{
+    /*
+     * Returns true if the line did not fit into the buffer and has been
+     * truncated.
+     */
+
+    return ttOverflow;
+}
+
+void TelemetryText::putUInt(uint32_t value, uint_fast8_t width)
+{
+    /*
+     * Append an unsigned decimal integer. The digits are generated from the
+     * back, two at a time (one division by 100 instead of two by 10).
+     *
+     * value: Integer to append.
+     * width: Minimum number of digits (leading zeros).
+     */
+
+    char digits[10];
+    uint_fast8_t pos = sizeof(digits);
+
+    while (value >= 100)
+    {
+        uint32_t pair = (value % 100) * 2;
+        value /= 100;
+        digits[--pos] = ttDigitPairs[pair + 1];
+        digits[--pos] = ttDigitPairs[pair];
+    }
+    if (value >= 10)
+    {
+        digits[--pos] = ttDigitPairs[value * 2 + 1];
+        digits[--pos] = ttDigitPairs[value * 2];
+    }
+    else
+    {
+        digits[--pos] = '0' + value;
+    }
+
+    for (uint_fast8_t count = sizeof(digits) - pos; count < width; count++)
+    {
+        putChar('0');
+    }
+    while (pos < sizeof(digits))
+    {
+        putChar(digits[pos++]);
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * TelemetryText.h
+ *
+ *    Author:
+ *     Email:
+ *
+ * Renders a text line of the debug values (Arduino serial plotter format, see
+ * System::sendDebugVals) into a buffer. Compared to UARTprintf it only
+ * supports what is needed for the debug values, but is much faster: integers
+ * are converted two digits at a time with a lookup table, and nothing is
+ * sent while formatting. The finished line can be handed to the non-blocking
+ * transmit queue (System::queueDebugTx).
+ */
+
+#ifndef TELEMETRYTEXT_H_
+#define TELEMETRYTEXT_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+
+class TelemetryText
+{
+public:
+    TelemetryText();
+    ~TelemetryText();
+    void begin();
+    void putChar(char c);
+    void putString(const char *str);
+    void putInt(int32_t value, uint_fast8_t width = 0);
+    void putFixed(float value, uint_fast8_t decimals);
+    void putHex(uint32_t value);
+    void endLine();
+    const char* getData();
+    uint32_t getLength();
+    bool overflowed();
+
+private:
+    void putUInt(uint32_t value, uint_fast8_t width);
+
+    /*
+     * Two bytes are reserved for the line end, so even a truncated line is
+     * terminated correctly.
+     */
+    const static uint32_t ttMaxLength = 512;
+    char ttBuffer[ttMaxLength];
+    uint32_t ttLength = 0;
+    bool ttOverflow = false;
+
+    // "00" "01" ... "99"
+    static const char ttDigitPairs[200];
+    // 10^0 ... 10^ttMaxDecimals
+    const static uint_fast8_t ttMaxDecimals = 6;
+    static const uint32_t ttPowersOf10[ttMaxDecimals + 1];
+};
+
+#endif /* TELEMETRYTEXT_H_ */
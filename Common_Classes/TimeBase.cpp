@@ -0,0 +1,193 @@
+/*
+ * TimeBase.cpp
+ *
+ *    Author:
+ *     Email:
+ *
+ * Microsecond time base and delays (see TimeBase.h).
+ */
+
+#include "TimeBase.h"
+
+
+uint64_t TimeBase::tbBaseTicks = 0;
+uint64_t TimeBase::tbBaseUS = 0;
+uint32_t TimeBase::tbTicksPerUS = 1;
+uint64_t TimeBase::tbDivider = 0;
+
+
+void TimeBase::init(uint32_t clk, uint32_t startUS)
+{
+    /*
+     * Start counting. Called by System::init once the CPU clock is set.
+     *
+     * clk:     The clock frequency of the CPU in Hz (a multiple of 1MHz, at
+     *          least 2MHz).
+     * startUS: Microseconds since the reset (counted by the startup code
+     *          until now, see System::init).
+     */
+
+    tbTicksPerUS = clk / 1000000;
+    tbDivider = UINT64_MAX / tbTicksPerUS + 1;
+
+#ifndef CFG_HOST_SIM
+    SysCtlPeripheralEnable(tbPeriph);
+
+    // Wait until peripheral is ready ("TivaWare(TM) Treiberbibliothek",
+    // SysCtlPeripheralReady)
+    while (!SysCtlPeripheralReady(tbPeriph));
+
+    // Both halves concatenated to one 64 bit timer counting up from 0 and
+    // stopping while the debugger halts the CPU ("TivaWare(TM)
+    // Treiberbibliothek", chapter "Timer").
+    TimerConfigure(tbBase, TIMER_CFG_PERIODIC_UP);
+    TimerLoadSet64(tbBase, UINT64_MAX);
+    TimerControlStall(tbBase, TIMER_A, true);
+
+    // The match interrupt only wakes the CPU (see TimeBase::sleepUntil). It
+    // has the lowest priority as it has nothing urgent to do.
+    TimerIntRegister(tbBase, TIMER_A, matchISR);
+    IntPrioritySet(tbInt, 0xe0);
+
+    TimerEnable(tbBase, TIMER_A);
+#endif
+
+    tbBaseTicks = 0;
+    tbBaseUS = startUS;
+}
+
+void TimeBase::updateClock(uint32_t clk)
+{
+    /*
+     * Continue counting with a new CPU clock. Called by System::setClockFreq
+     * right after the clock change, with all interrupts disabled
+     * (IntMasterDisable), so no ISR can read the time while it changes.
+     *
+     * clk: The new clock frequency of the CPU in Hz.
+     */
+
+#ifndef CFG_HOST_SIM
+    // The few cycles since the clock change are counted with the old clock.
+    uint64_t ticks = TimerValueGet64(tbBase);
+    tbBaseUS += mulHigh(ticks - tbBaseTicks, tbDivider);
+    tbBaseTicks = ticks;
+#endif
+    tbTicksPerUS = clk / 1000000;
+    tbDivider = UINT64_MAX / tbTicksPerUS + 1;
+}
+
+uint64_t TimeBase::getUS()
+{
+    /*
+     * Returns the microseconds since the reset. Can be called from any
+     * context, including ISRs of preemption priority 0, as the clock is only
+     * changed with all interrupts disabled (see TimeBase::updateClock).
+     * The division of the ticks by tbTicksPerUS (a library call of several
+     * hundred cycles for 64 bits) is replaced by a multiplication with
+     * tbDivider = 2^64 / tbTicksPerUS (rounded up) and taking the upper 64
+     * bits. The result is exact as long as the ticks since the last clock
+     * change stay below 2^64 / tbTicksPerUS (over 90 years at 80MHz).
+     * Before TimeBase::init (f.ex. an error during System::init) the timer
+     * is not enabled yet and 0 is returned.
+     */
+
+#ifdef CFG_HOST_SIM
+    static const auto start = std::chrono::steady_clock::now();
+    return tbBaseUS + std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+#else
+    if (!tbDivider)
+    {
+        return 0;
+    }
+    return tbBaseUS + mulHigh(TimerValueGet64(tbBase) - tbBaseTicks,
+                              tbDivider);
+#endif
+}
+
+uint64_t TimeBase::getTicks()
+{
+    /*
+     * Returns the timer value in CPU cycles, f.ex. to measure short
+     * durations with the resolution of one cycle (12.5ns at 80MHz). Can be
+     * called from any context. Unlike the cycle counter it does not overflow
+     * and keeps counting while the core sleeps (WFI). Differences are only
+     * meaningful if the CPU clock did not change in between. Returns 0
+     * before TimeBase::init.
+     */
+
+#ifdef CFG_HOST_SIM
+    return getUS() * tbTicksPerUS;
+#else
+    return tbDivider ? TimerValueGet64(tbBase) : 0;
+#endif
+}
+
+void TimeBase::delayUS(uint64_t us)
+{
+    /*
+     * Sleep for at least the given amount of microseconds (see
+     * TimeBase::sleepUntil). Do not call it from an ISR.
+     *
+     * us: Delay in microseconds
+     */
+
+    sleepUntil(getUS() + us);
+}
+
+void TimeBase::sleepUntil(uint64_t timeUS)
+{
+    /*
+     * Sleep until the given time (see TimeBase::getUS). The timer wakes the
+     * CPU with a match interrupt at that time; all other interrupts are
+     * handled as usual meanwhile.
+     * Note: Do not call it from an ISR. Lower priority interrupts could not
+     *       be handled and the match interrupt itself might not preempt it.
+     *
+     * timeUS: End of the sleep in microseconds since the reset.
+     */
+
+#ifdef CFG_HOST_SIM
+    while (getUS() < timeUS);
+#else
+    // Interrupts are disabled while checking the time, otherwise an ISR
+    // between the check and WFI could consume the wake-up interrupt. Pending
+    // interrupts still end the sleep and are handled when enabled again
+    // (unless the caller disabled them).
+    bool disabled = IntMasterDisable();
+    while (getUS() < timeUS)
+    {
+        // Time of the match as timer value. The clock is only changed in the
+        // background loop, so not while sleeping here.
+        uint64_t remaining = timeUS - getUS();
+        TimerMatchSet64(tbBase, TimerValueGet64(tbBase)
+                                + remaining * tbTicksPerUS);
+        TimerIntClear(tbBase, TIMER_TIMA_MATCH);
+        TimerIntEnable(tbBase, TIMER_TIMA_MATCH);
+        IntEnable(tbInt);
+
+        SysCtlSleep();
+
+        if (!disabled)
+        {
+            IntMasterEnable();
+            IntMasterDisable();
+        }
+    }
+    TimerIntDisable(tbBase, TIMER_TIMA_MATCH);
+    if (!disabled)
+    {
+        IntMasterEnable();
+    }
+#endif
+}
+
+void TimeBase::matchISR()
+{
+    /*
+     * Match interrupt of the timer. Only wakes the CPU (see
+     * TimeBase::sleepUntil).
+     */
+
+    TimerIntClear(tbBase, TIMER_TIMA_MATCH);
+}
@@ -0,0 +1,165 @@
+/*
+ * TimeBase.h
+ *
+ *    Author:
+ *     Email:
+ *
+ * Time in microseconds since the reset, counted by the wide timer WTIMER5 in
+ * 64 bit mode from System::init on (before that by the cycle counter, see
+ * System::init). Unlike SysCtlDelay (whose duration depends on the
+ * flash wait states) and the 32 bit cycle counter it is exact and never
+ * overflows (2^64 CPU cycles are thousands of years), so delays of any
+ * length are possible.
+ * - TimeBase::delayUS waits with the core in sleep mode (WFI) until a match
+ *   interrupt of the timer at the end of the delay. Other interrupts are
+ *   handled meanwhile.
+ * - Deadline is the non-blocking variant for polling loops.
+ * TimeBase::getUS and TimeBase::getTicks can be called from any context (ISRs
+ * included) and take well below a microsecond; the conversion to
+ * microseconds needs no division (see TimeBase::getUS). getTicks has the
+ * resolution of one CPU cycle, f.ex. for profiling.
+ * The timer counts CPU cycles. When the CPU clock changes (see
+ * System::setClockFreq) the time counted so far is kept and the new clock is
+ * used from then on. The time does not advance during deep-sleep, as the
+ * timer stops (see System::deepSleep).
+ * When compiled for the host (CFG_HOST_SIM defined) the host's monotonic
+ * clock is used instead.
+ * Note: There is only one time base, therefore all methods are static.
+ */
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * inc/hw_memmap.h:         Macros defining the memory map of the Tiva C Series
+ *                          device. This includes defines such as peripheral
+ *                          base address locations such as GPIO_PORTF_BASE.
+ * inc/hw_ints.h:           Interrupt assignments (INT_WTIMER5A).
+ * driverlib/sysctl.h:      Defines and macros for the System Control API of
+ *                          DriverLib. This includes API functions such as
+ *                          SysCtlClockSet.
+ * driverlib/interrupt.h:   Defines and macros for NVIC Controller API of
+ *                          DriverLib. This includes API functions such as
+ *                          IntEnable and IntPrioritySet.
+ * driverlib/timer.h:       Defines and macros for the Timer API of
+ *                          DriverLib.
+ * chrono:                  (Host only) monotonic clock of the host system.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/timer.h"
+#ifdef CFG_HOST_SIM
+#include <chrono>
+#endif
+
+
+class TimeBase
+{
+public:
+    static void init(uint32_t clk, uint32_t startUS = 0);
+    static void updateClock(uint32_t clk);
+    static uint64_t getUS();
+    static uint64_t getTicks();
+    static void delayUS(uint64_t us);
+    static void sleepUntil(uint64_t timeUS);
+
+private:
+    static void matchISR();
+
+    static inline uint64_t mulHigh(uint64_t a, uint64_t b)
+    {
+        /*
+         * Returns the upper 64 bits of the 128 bit product a * b, built from
+         * the 32 bit partial products (the Cortex-M4 multiplies 32x32->64 bit
+         * in one instruction, UMULL).
+         */
+
+        uint64_t aLow = (uint32_t) a, aHigh = a >> 32;
+        uint64_t bLow = (uint32_t) b, bHigh = b >> 32;
+        uint64_t low = aLow * bLow;
+        uint64_t cross1 = aLow * bHigh;
+        uint64_t cross2 = aHigh * bLow;
+        uint64_t middle = (low >> 32) + (uint32_t) cross1 + (uint32_t) cross2;
+        return aHigh * bHigh + (cross1 >> 32) + (cross2 >> 32) + (middle >> 32);
+    }
+
+    const static uint32_t tbBase = WTIMER5_BASE;
+    const static uint32_t tbPeriph = SYSCTL_PERIPH_WTIMER5;
+    const static uint32_t tbInt = INT_WTIMER5A;
+
+    // Time at the last clock change: timer value and microseconds.
+    static uint64_t tbBaseTicks, tbBaseUS;
+    static uint32_t tbTicksPerUS;
+
+    // Reciprocal of tbTicksPerUS scaled by 2^64 (see TimeBase::getUS).
+    static uint64_t tbDivider;
+};
+
+
+class Deadline
+{
+    /*
+     * Point in time for polling loops, f.ex.
+     *   Deadline timeout(50000);
+     *   while (!ready() && !timeout.expired());
+     */
+
+public:
+    Deadline(uint64_t us = 0)
+    {
+        /*
+         * Create a deadline <us> microseconds from now.
+         */
+
+        set(us);
+    }
+
+    void set(uint64_t us)
+    {
+        /*
+         * Move the deadline to <us> microseconds from now.
+         */
+
+        dlEnd = TimeBase::getUS() + us;
+    }
+
+    bool expired()
+    {
+        /*
+         * Returns true once the deadline has been reached.
+         */
+
+        return TimeBase::getUS() >= dlEnd;
+    }
+
+    uint64_t getRemainingUS()
+    {
+        /*
+         * Returns the microseconds until the deadline, 0 once it expired.
+         */
+
+        uint64_t now = TimeBase::getUS();
+        return (now < dlEnd) ? dlEnd - now : 0;
+    }
+
+    void wait()
+    {
+        /*
+         * Sleep until the deadline (see TimeBase::sleepUntil).
+         */
+
+        TimeBase::sleepUntil(dlEnd);
+    }
+
+private:
+    uint64_t dlEnd;
+};
+
+#endif /* TIMEBASE_H_ */
@@ -3,17 +3,23 @@
  *
  *    Author:
  *     Email:
+ *
+ * Periodic or one-shot interrupt of a general purpose timer (see Timer.h).
  */
 
+#include <Timer.h>
 
-// Uncomment following #define to use the precompiled Timer library instead of
-// the code in this file.
-// #define USE_TIMER_LIBRARY
 
-#ifndef USE_TIMER_LIBRARY
+// Storage of the static table (values in Timer.h), in the flash.
+constexpr uint32_t Timer::timerConstants[11][3];
 
+Delegate Timer::timerDelegates[11];
 
-#include <Timer.h>
+// Registered as ISR instead of the delegate, one per timer.
+void (* const Timer::timerDispatchers[11])(void) =
+                 {dispatch<0>, dispatch<1>, dispatch<2>, dispatch<3>,
+                  dispatch<4>, dispatch<5>, dispatch<6>, dispatch<7>,
+                  dispatch<8>, dispatch<9>, dispatch<10>};
 
 
 Timer::Timer()
@@ -30,4 +36,225 @@ Timer::~Timer()
      */
 }
 
-#endif
+void Timer::init(System *sys, uint32_t base, void (*ISR)(void), uint32_t freq,
+                 TimerMode mode)
+{
+    /*
+     * Initialize the timer calling the given ISR. It is not started yet (see
+     * Timer::start).
+     *
+     * sys:  Pointer to the current System object.
+     * base: Base address of the timer (TIMER0_BASE-TIMER5_BASE,
+     *       WTIMER0_BASE-WTIMER4_BASE).
+     * ISR:  Function called at each timeout. It must call
+     *       Timer::clearInterruptFlag.
+     * freq: Optional frequency of the interrupt in Hz. Can be set later with
+     *       Timer::setFreq or Timer::setPeriodUS.
+     * mode: Optional, TimerPeriodic (default) or TimerOneShot.
+     */
+
+    configure(sys, base, freq, mode);
+
+    // Registers the ISR and enables the interrupt in the NVIC.
+    TimerIntRegister(timerBase, TIMER_A, ISR);
+    TimerIntEnable(timerBase, TIMER_TIMA_TIMEOUT);
+}
+
+void Timer::init(System *sys, uint32_t base, Delegate ISR, uint32_t freq,
+                 TimerMode mode)
+{
+    /*
+     * Initialize the timer calling the given delegate. The interrupt flag is
+     * cleared before the delegate is called. It is not started yet (see
+     * Timer::start).
+     *
+     * sys:  Pointer to the current System object.
+     * base: Base address of the timer (TIMER0_BASE-TIMER5_BASE,
+     *       WTIMER0_BASE-WTIMER4_BASE).
+     * ISR:  Method or function called at each timeout, see Delegate::bind.
+     * freq: Optional frequency of the interrupt in Hz. Can be set later with
+     *       Timer::setFreq or Timer::setPeriodUS.
+     * mode: Optional, TimerPeriodic (default) or TimerOneShot.
+     */
+
+    configure(sys, base, freq, mode);
+
+    // The interrupt is still disabled, so the delegate cannot be called
+    // while it is being written.
+    timerDelegates[timerIndex] = ISR;
+    TimerIntRegister(timerBase, TIMER_A, timerDispatchers[timerIndex]);
+    TimerIntEnable(timerBase, TIMER_TIMA_TIMEOUT);
+}
+
+void Timer::configure(System *sys, uint32_t base, uint32_t freq,
+                      TimerMode mode)
+{
+    /*
+     * Common part of both Timer::init variants: configure the timer in the
+     * given mode and set the frequency (if given).
+     */
+
+    timerSys = sys;
+    timerBase = base;
+
+    uint_fast8_t timer = 0;
+    while ((timer < timerCount) && (timerConstants[timer][0] != base))
+    {
+        timer++;
+    }
+    if (timer >= timerCount)
+    {
+        timerSys->error(TimerWrongConfig, &base);
+    }
+
+    timerIndex = timer;
+    timerSys->enablePeripheral(timerConstants[timer][1]);
+
+    // 32 bit timer, counting down ("TivaWare(TM) Treiberbibliothek",
+    // chapter "Timer"). Wide timers are split, timer A has 32 bits then.
+    bool oneShot = (mode == TimerOneShot);
+    if (timer < timerFirstWide)
+    {
+        TimerConfigure(timerBase, oneShot ? TIMER_CFG_ONE_SHOT
+                                          : TIMER_CFG_PERIODIC);
+    }
+    else
+    {
+        TimerConfigure(timerBase, TIMER_CFG_SPLIT_PAIR
+                                  | (oneShot ? TIMER_CFG_A_ONE_SHOT
+                                             : TIMER_CFG_A_PERIODIC));
+    }
+
+    // The timer stops while the debugger halts the CPU.
+    TimerControlStall(timerBase, TIMER_A, true);
+
+    if (freq)
+    {
+        setFreq(freq);
+    }
+}
+
+void Timer::start()
+{
+    /*
+     * Start counting. The first interrupt follows one period later.
+     */
+
+    TimerEnable(timerBase, TIMER_A);
+}
+
+void Timer::stop()
+{
+    /*
+     * Stop counting. Timer::start continues where it stopped.
+     */
+
+    TimerDisable(timerBase, TIMER_A);
+}
+
+void Timer::restartUS(uint32_t periodUS)
+{
+    /*
+     * Stop the timer, discard a pending timeout and start it again with the
+     * given period, f.ex. to restart a one-shot timeout. Can be called from
+     * an ISR.
+     *
+     * periodUS: Time until the (next) timeout in microseconds (> 0).
+     */
+
+    TimerDisable(timerBase, TIMER_A);
+    TimerIntClear(timerBase, TIMER_TIMA_TIMEOUT);
+    IntPendClear(timerConstants[timerIndex][2]);
+    setPeriodUS(periodUS);
+    TimerEnable(timerBase, TIMER_A);
+}
+
+void Timer::setPeriodUS(uint32_t periodUS)
+{
+    /*
+     * Set the time between two interrupts. Takes effect immediately: the
+     * timer reloads its counter with the new period in the next cycle
+     * (TnILD is not set, see "TivaC Mikrocontroller Datenblatt", GPTMTnMR),
+     * so the current period is restarted.
+     *
+     * periodUS: Period in microseconds (> 0).
+     */
+
+    if (!periodUS)
+    {
+        timerSys->error(TimerWrongFreq, &timerBase, &periodUS);
+    }
+
+    setLoad((uint64_t) periodUS * (timerSys->getClockFreq() / 1000000));
+    timerPeriodUS = periodUS;
+    timerFreq = 1000000 / periodUS;
+}
+
+void Timer::setFreq(uint32_t frequency)
+{
+    /*
+     * Set the frequency of the interrupt. Takes effect immediately, the
+     * current period is restarted (see Timer::setPeriodUS).
+     *
+     * frequency: Frequency in Hz (> 0, at most the CPU clock).
+     */
+
+    if (!frequency)
+    {
+        timerSys->error(TimerWrongFreq, &timerBase, &frequency);
+    }
+
+    setLoad(timerSys->getClockFreq() / frequency);
+    timerFreq = frequency;
+    timerPeriodUS = 1000000 / frequency;
+}
+
+uint32_t Timer::getFreq()
+{
+    /*
+     * Returns the frequency of the interrupt in Hz.
+     */
+
+    return timerFreq;
+}
+
+uint32_t Timer::getPeriodUS()
+{
+    /*
+     * Returns the time between two interrupts in microseconds.
+     */
+
+    return timerPeriodUS;
+}
+
+void Timer::setLoad(uint64_t cycles)
+{
+    /*
+     * Set the period of the timer in CPU cycles. The timer counts from the
+     * load value down to 0, so one period is one cycle longer than the load
+     * value.
+     *
+     * cycles: Period in CPU cycles (1 - 2^32).
+     */
+
+    if (!cycles || (cycles > 0x100000000ull))
+    {
+        timerSys->error(TimerWrongFreq, &timerBase, &cycles);
+    }
+
+    TimerLoadSet(timerBase, TIMER_A, cycles - 1);
+}
+
+template <uint_fast8_t Index>
+RAMFUNC void Timer::dispatch()
+{
+    /*
+     * ISR of the timer timerConstants[Index] if it calls a delegate. Clears
+     * the interrupt flag and calls the delegate. The base address is a
+     * constant here, so this costs only a few instructions more than an ISR
+     * function.
+     */
+
+    TimerIntClear(timerConstants[Index][0], TIMER_TIMA_TIMEOUT);
+    timerDelegates[Index]();
+}
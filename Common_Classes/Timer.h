@@ -3,6 +3,23 @@
  *
  *    Author: Max Zuidberg
  *     Email: m.zuidberg@icloud.com
+ *
+ * Periodic or one-shot interrupt of a general purpose timer. The 16/32 bit
+ * timers (TIMER0-5) count with their full 32 bits, the wide timers
+ * (WTIMER0-4) with their 32 bit half A, so the period is at most 2^32 CPU
+ * cycles (53s at 80MHz). WTIMER5 is reserved for the time base (see TimeBase.h).
+ * The timer counts CPU cycles; after a change of the CPU clock the frequency
+ * must be set again (see System::setClockFreq).
+ * The ISR is either a function, which must clear the interrupt flag itself
+ * (Timer::clearInterruptFlag), or a delegate (see Delegate.h), which can
+ * call a method of an object directly. Delegates are called by a dispatcher
+ * per timer, which clears the interrupt flag first.
+ * A one-shot timer (TimerOneShot) stops after its timeout. Timer::restartUS
+ * starts it again, f.ex. as a timeout restarted by every edge of a signal.
+ *
+ * Example:
+ *   timer.init(&sys, TIMER0_BASE,
+ *              Delegate::bind<Segway, &Segway::update>(&segway), 100);
  */
 
 #ifndef TIMER_H_
@@ -12,34 +29,96 @@
 /*
  * stdbool.h:               Boolean definitions for the C99 standard
  * stdint.h:                Variable definitions for the C99 standard
+ * inc/hw_memmap.h:         Base addresses of the timers.
+ * inc/hw_ints.h:           Interrupt assignments of the timers.
+ * driverlib/sysctl.h:      Defines and macros for the System Control API of
+ *                          DriverLib (peripherals of the timers).
+ * driverlib/timer.h:       Defines and macros for the Timer API of
+ *                          DriverLib.
+ * driverlib/interrupt.h:   Defines and macros for NVIC Controller API of
+ *                          DriverLib (IntPendClear).
  * System.h:                Access to current CPU clock and other functions.
+ * Delegate.h:              Methods of objects as ISR.
  */
 #include <stdbool.h>
 #include <stdint.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "driverlib/interrupt.h"
 #include "System.h"
+#include "Delegate.h"
+
+
+enum TimerMode {TimerPeriodic,      // Timeout every period
+                TimerOneShot};      // One timeout per Timer::start
 
 
 class Timer
 {
 public:
     Timer();
-    virtual ~Timer();
-    void init(System* sys, uint32_t base, void (*ISR)(void), uint32_t freq = 0);
+    ~Timer();
+    void init(System* sys, uint32_t base, void (*ISR)(void), uint32_t freq = 0,
+              TimerMode mode = TimerPeriodic);
+    void init(System* sys, uint32_t base, Delegate ISR, uint32_t freq = 0,
+              TimerMode mode = TimerPeriodic);
     void start();
     void stop();
-    void clearInterruptFlag();
+    void restartUS(uint32_t periodUS);
     void setPeriodUS(uint32_t periodUS);
     void setFreq(uint32_t frequency);
     uint32_t getFreq();
     uint32_t getPeriodUS();
+
+    inline void clearInterruptFlag()
+    {
+        /*
+         * Clear the timeout interrupt. Must be called by an ISR function,
+         * otherwise the ISR is entered again right after it returns. Not
+         * needed for delegates.
+         */
+
+        TimerIntClear(timerBase, TIMER_TIMA_TIMEOUT);
+    }
+
 private:
-    /*
-     * The following array is needed to let the compiler know that the
-     * precompiled class library needs space for its private variables.
-     * Or in shorter terms: simply ignore it.
-     */
-    uint32_t spaceForLib[13];
+    void configure(System *sys, uint32_t base, uint32_t freq,
+                   TimerMode mode);
+    void setLoad(uint64_t cycles);
+
+    template <uint_fast8_t Index>
+    static void dispatch();
+
+    System *timerSys;
+    uint32_t timerBase = 0;
+    uint_fast8_t timerIndex = 0;        // In timerConstants
+    uint32_t timerFreq = 0, timerPeriodUS = 0;
+
+    // Timers which can be used: base address, peripheral and interrupt.
+    // Static, so it stays in the flash.
+    static constexpr uint_fast8_t timerCount = 11;
+    static constexpr uint32_t timerConstants[11][3] =
+                 {{TIMER0_BASE, SYSCTL_PERIPH_TIMER0, INT_TIMER0A},
+                  {TIMER1_BASE, SYSCTL_PERIPH_TIMER1, INT_TIMER1A},
+                  {TIMER2_BASE, SYSCTL_PERIPH_TIMER2, INT_TIMER2A},
+                  {TIMER3_BASE, SYSCTL_PERIPH_TIMER3, INT_TIMER3A},
+                  {TIMER4_BASE, SYSCTL_PERIPH_TIMER4, INT_TIMER4A},
+                  {TIMER5_BASE, SYSCTL_PERIPH_TIMER5, INT_TIMER5A},
+                  {WTIMER0_BASE, SYSCTL_PERIPH_WTIMER0, INT_WTIMER0A},
+                  {WTIMER1_BASE, SYSCTL_PERIPH_WTIMER1, INT_WTIMER1A},
+                  {WTIMER2_BASE, SYSCTL_PERIPH_WTIMER2, INT_WTIMER2A},
+                  {WTIMER3_BASE, SYSCTL_PERIPH_WTIMER3, INT_WTIMER3A},
+                  {WTIMER4_BASE, SYSCTL_PERIPH_WTIMER4, INT_WTIMER4A}};
+
+    // The first wide timer in timerConstants.
+    static constexpr uint_fast8_t timerFirstWide = 6;
 
+    // Delegate of each timer (same order as timerConstants) and the
+    // dispatchers calling them, see Timer.cpp.
+    static Delegate timerDelegates[11];
+    static void (* const timerDispatchers[11])(void);
 };
 
 #endif /* TIMER_H_ */
@@ -34,12 +34,22 @@ SECTIONS
     .cinit  :   > FLASH
     .pinit  :   > FLASH
     .init_array : > FLASH
+    .binit  :   > FLASH
 
+    /* Functions executed from the SRAM (RAMFUNC, see System.h). Stored in  */
+    /* the flash and copied to the SRAM by the startup code (_c_int00) with */
+    /* the copy table in .binit.                                            */
+    .TI.ramfunc : {} load = FLASH, run = SRAM, table(BINIT)
+
+    /* Vector table in the SRAM, filled by IntRegister (driverlib). */
     .vtable :   > 0x20000000
     .data   :   > SRAM
     .bss    :   > SRAM
     .sysmem :   > SRAM
     .stack  :   > SRAM
+
+    /* Not initialized by the startup code, survives resets (BlackBox) */
+    .noinit :   > SRAM, type = NOINIT
 }
 
 __STACK_TOP = __stack + 512;
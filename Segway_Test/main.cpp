@@ -34,62 +34,184 @@ Segway segway;
 Timer mainTimer;
 Timer debugTimer;
 
+// Worst case delay between the main timer timeout and the start of its ISR.
+uint32_t mainTimerMaxLatency = 0;
+DebugHandle mainTimerLatencyDebug;
 
-void mainTimerISR()
+// Time from leaving the standby until the full CPU clock is restored.
+uint32_t wakeLatencyUS = 0;
+DebugHandle wakeLatencyDebug, clockDebug;
+
+
+RAMFUNC void mainTimerISR()
 {
     /*
-     * This ISR is periodically called by the updateTimer. It causes the
-     * segway class to update all inputs and set the corresponding new outputs.
-     *
-     * Note: it is not possible to set a class method as ISR. Therefore this
-     *       "helper-function" is needed.
+     * This ISR is periodically called by the mainTimer (which clears the
+     * interrupt flag, see Timer::init). It causes the segway class to update
+     * all inputs and set the corresponding new outputs. Around that it
+     * measures the interrupt latency and frames the debug values of the
+     * control cycle.
      */
 
-    mainTimer.clearInterruptFlag();
+    /*
+     * The timer counts down and is reloaded at the timeout that triggered
+     * this ISR. Therefore the elapsed cycles since the reload are the
+     * interrupt latency (f.ex. caused by other ISRs or critical sections).
+     */
+    uint32_t latency = TimerLoadGet(CFG_MAIN_TIMER_BASE, TIMER_A)
+                       - TimerValueGet(CFG_MAIN_TIMER_BASE, TIMER_A);
+    if (latency > mainTimerMaxLatency)
+    {
+        mainTimerMaxLatency = latency;
+    }
+
+    // All debug values of this control cycle are transmitted together.
+    system.beginDebugUpdate();
+
+    system.setDebugVal(mainTimerLatencyDebug, mainTimerMaxLatency);
+    system.setDebugVal(wakeLatencyDebug, wakeLatencyUS);
+    system.setDebugVal(clockDebug, system.getClockFreq() / 1000000);
 
     // Update segway
     segway.update();
+
+    system.endDebugUpdate();
 }
 
-void sendDebugISR()
+void debugUARTISR()
 {
     /*
-     * This ISR is periodically called by the debugTsimer. It causes the system
-     * class to transmit the latest debug values.
-     *
-     * Note: it is not possible to set a class method as ISR. Therefore this
-     *       "helper-function" is needed.
+     * Called by the USB UART when a uDMA transfer of the debug data is
+     * complete. The system class starts the next one.
+     */
+
+    system.debugTxISR();
+}
+
+void footSwitchISR()
+{
+    /*
+     * Edge of the foot switch (see Segway::enableFootSwitchInt).
      */
 
-	debugTimer.clearInterruptFlag();
+    segway.footSwitchISR();
+}
 
-	// Transmit debug values
-	system.sendDebugVals();
+void setClockFreq(uint32_t clk)
+{
+    /*
+     * Change the CPU clock and adapt everything depending on it: the debug
+     * UART (System), the timers and the peripherals of the segway. The
+     * control ISR is masked until all of them use the new clock, otherwise
+     * it could f.ex. read the sensor with twice the I2C bit rate.
+     *
+     * clk: The new clock frequency, see System::init.
+     */
+
+    uint32_t state = system.setClockFreq(clk);
+    mainTimer.setFreq(CFG_CTLR_UPDATE_FREQ);
+    debugTimer.setFreq(CFG_DEBUG_TIMER_FREQ);
+    segway.updateClock();
+    system.exitCritical(state);
 }
 
 int main(void)
 {
     // Initialize objects according to the values in Config.h
-    system.init(CFG_SYS_FREQ);
-
+    system.init(CFG_SYS_FREQ, CFG_DEBUG_BAUD);
+    system.setDebugFormat(CFG_DEBUG_FORMAT);
+    if (CFG_DEBUG_DMA)
+    {
+        system.enableDebugDMA(debugUARTISR);
+    }
+
+    // Errors which may be temporary: restart instead of halting.
+    if (CFG_SYS_RESTART_ON_ERROR)
+    {
+        system.setErrorRecoverable(CPUFault);
+        system.setErrorRecoverable(MPUCommunicationError);
+    }
+
+    // Report what happened before the last reset (if the black box content
+    // survived it) before the control ISR overwrites it.
+    if (BlackBox::hasContent())
+    {
+        BlackBox::dump(&system);
+    }
+    mainTimerLatencyDebug = system.registerDebugVal("ISR_Latency_Max_[cycles]");
+    wakeLatencyDebug = system.registerDebugVal("Wake_Latency_[us]");
+    clockDebug = system.registerDebugVal("CPU_Clock_[MHz]", DebugInt16);
+
+    // The debug timer transmits the latest debug values directly.
     mainTimer.init(&system,
                    CFG_MAIN_TIMER_BASE,
-                   mainTimerISR,
+                   Delegate::bind<mainTimerISR>(),
                    CFG_CTLR_UPDATE_FREQ);
     debugTimer.init(&system,
                     CFG_DEBUG_TIMER_BASE,
-                    sendDebugISR,
+                    Delegate::bind<System, &System::sendDebugVals>(&system),
                     CFG_DEBUG_TIMER_FREQ);
 
+    /*
+     * Apply the interrupt priority plan from Config.h. Most importantly the
+     * main timer must preempt the (slow) transmission of the debug values.
+     */
+    system.setIntPriority(CFG_MAIN_TIMER_INT,
+                          CFG_PRIO_MAIN_TIMER,
+                          CFG_SUBPRIO_MAIN_TIMER);
+    system.setIntPriority(CFG_SENSOR_I2C_INT,
+                          CFG_PRIO_SENSOR_I2C,
+                          CFG_SUBPRIO_SENSOR_I2C);
+    system.setIntPriority(CFG_BATT_INT,
+                          CFG_PRIO_ADC,
+                          CFG_SUBPRIO_ADC);
+    system.setIntPriority(CFG_STEERING_INT,
+                          CFG_PRIO_ADC,
+                          CFG_SUBPRIO_ADC);
+    system.setIntPriority(CFG_DEBUG_UART_INT,
+                          CFG_PRIO_UART,
+                          CFG_SUBPRIO_UART);
+    system.setIntPriority(CFG_DEBUG_TIMER_INT,
+                          CFG_PRIO_DEBUG_TIMER,
+                          CFG_SUBPRIO_DEBUG_TIMER);
+    system.setIntPriority(CFG_FS_INT,
+                          CFG_PRIO_FOOTSWITCH,
+                          CFG_SUBPRIO_FOOTSWITCH);
+    system.setIntPriority(CFG_FS_DEBOUNCE_TIMER_INT,
+                          CFG_PRIO_FOOTSWITCH,
+                          CFG_SUBPRIO_FOOTSWITCH);
+
     // Initialize and start segway
     segway.init(&system);
+    segway.enableFootSwitchInt(footSwitchISR);
+    system.markBoot(BootApplication);
     mainTimer.start();
     debugTimer.start();
 
 	while (42)
 	{
+	    /*
+	     * Save power in standby with a lower CPU clock. The control ISR
+	     * leaving the standby wakes the background loop from its sleep, so
+	     * the full clock is restored right afterwards, before the next control
+	     * cycle needs the sensor.
+	     */
+	    bool standby = segway.isStandby();
+	    uint32_t clk = standby ? CFG_SYS_STANDBY_FREQ : CFG_SYS_FREQ;
+	    if (clk != system.getClockFreq())
+	    {
+	        setClockFreq(clk);
+
+	        // The time base keeps counting across the clock change.
+	        if (!standby)
+	        {
+	            wakeLatencyUS = TimeBase::getUS() - segway.getWakeTimestamp();
+	        }
+	    }
+
 	    // Some monitoring tasks can run silently in background while the
-	    // critical parts run inside the ISR
+	    // critical parts run inside the ISR. Sleeps until the next interrupt
+	    // when done (if enabled in Config.h).
 	    segway.backgroundTasks();
 	}
 }
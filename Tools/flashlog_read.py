@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""
+flashlog_read.py
+
+   Author:
+    Email:
+
+Reader for the log of the segway on the external SPI NOR flash (see
+FlashLog.h). It works on an image of the whole flash, f.ex. read out with
+flashrom and a CH341A programmer, and lists the runs or writes the control
+cycle records (Segway::logRecord) of one run as CSV to stdout.
+Only the sector headers are needed to find the runs and the sector containing
+a given record (the index of the log), so even large images are processed
+quickly. Records with a wrong CRC are counted and reported on stderr.
+
+Examples:
+  flashlog_read.py --image flash.bin --list
+  flashlog_read.py --image flash.bin --run 12 > run12.csv
+  flashlog_read.py --image flash.bin --run 12 --start 6000 --count 500
+"""
+
+import argparse
+import mmap
+import struct
+import sys
+
+from telemetry_decode import cobs_decode, crc16
+
+
+SECTOR_SIZE = 4096
+MAGIC = 0x474f4c46
+HEADER = struct.Struct("<IIHHI")     # FlashLogSector
+FRAME_RECORD = 0x04
+RECORD = struct.Struct("<BHIHB8h")  # TELEMETRY_FRAME_RECORD without CRC
+
+COLUMNS = ["Record", "Time_[s]", "Cycle", "Duration_[cycles]", "Standby",
+           "FootSwitch", "Triggers", "Steering", "AngleRate_[rad/s]",
+           "AccelHor_[g]", "AccelVer_[g]", "Angle_[rad]", "DriveSpeed",
+           "LeftDuty", "RightDuty"]
+
+
+def read_index(image):
+    """Valid sector headers as (seq, run, first_offset, first_record, address),
+    in write order."""
+    index = []
+    for address in range(0, len(image) - SECTOR_SIZE + 1, SECTOR_SIZE):
+        magic, seq, run, first_offset, first_record = \
+            HEADER.unpack_from(image, address)
+        if magic == MAGIC:
+            index.append((seq, run, first_offset, first_record, address))
+    if not index:
+        return index
+    # Sequence numbers may have overflowed: start after the largest gap.
+    index.sort()
+    gaps = [(index[i][0] - index[i - 1][0]) & 0xffffffff
+            for i in range(len(index))]
+    oldest = max(range(len(index)), key=lambda i: gaps[i])
+    return index[oldest:] + index[:oldest]
+
+
+def runs(index):
+    """Group the index into runs: {run: [sectors]} (in write order)."""
+    result = {}
+    for sector in index:
+        result.setdefault(sector[1], []).append(sector)
+    return result
+
+
+def payload(image, sectors, start):
+    """Bytes of the run from the given sector index on, starting with the first
+    complete record."""
+    data = bytearray()
+    for number, (_, _, first_offset, _, address) in enumerate(sectors[start:]):
+        chunk = image[address + HEADER.size:address + SECTOR_SIZE]
+        if number == 0:
+            chunk = chunk[first_offset:]
+        if number == len(sectors) - start - 1:
+            # The rest of the last sector has not been written (yet).
+            chunk = chunk.rstrip(b"\xff")
+        data += chunk
+    return data
+
+
+def records(image, sectors, first):
+    """Yield (record number, record fields) from record <first> on. Returns the
+    number of CRC errors via StopIteration.value."""
+    start = 0
+    for i, sector in enumerate(sectors):
+        if sector[3] <= first:
+            start = i
+    number = sectors[start][3]
+    errors = 0
+    for encoded in bytes(payload(image, sectors, start)).split(b"\x00"):
+        if not encoded:
+            # Delimiter or padding of a flushed page
+            continue
+        try:
+            raw = cobs_decode(encoded)
+        except ValueError:
+            raw = b""
+        if (len(raw) != RECORD.size + 2 or raw[0] != FRAME_RECORD
+                or crc16(raw[:-2]) != struct.unpack("<H", raw[-2:])[0]):
+            errors += 1
+            number += 1
+            continue
+        if number >= first:
+            yield number, RECORD.unpack_from(raw)
+        number += 1
+    return errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1],
+                                     formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("--image", required=True, help="image of the whole flash")
+    parser.add_argument("--list", action="store_true", help="list the runs")
+    parser.add_argument("--run", type=int, help="run to extract (default: newest)")
+    parser.add_argument("--start", type=int, default=0, help="first record")
+    parser.add_argument("--count", type=int, help="number of records")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as stream:
+        image = mmap.mmap(stream.fileno(), 0, access=mmap.ACCESS_READ)
+    index = read_index(image)
+    if not index:
+        raise SystemExit("no log found in the image")
+    all_runs = runs(index)
+
+    if args.list:
+        print("run\tsectors\tfirst record\tflash address")
+        for run, sectors in all_runs.items():
+            print("%d\t%d\t%d\t0x%06x" % (run, len(sectors), sectors[0][3],
+                                          sectors[0][4]))
+        return
+
+    run = index[-1][1] if args.run is None else args.run
+    if run not in all_runs:
+        raise SystemExit("run %d not found (see --list)" % run)
+
+    print(",".join(COLUMNS))
+    generator = records(image, all_runs[run], args.start)
+    written = 0
+    time = 0
+    last_timestamp = None
+    errors = 0
+    while args.count is None or written < args.count:
+        try:
+            number, fields = next(generator)
+        except StopIteration as stop:
+            errors = stop.value or 0
+            break
+        _, cycle, timestamp, duration, flags = fields[:5]
+        # The 32 bit microsecond timestamps overflow every ~71 minutes.
+        if last_timestamp is not None:
+            time += (timestamp - last_timestamp) & 0xffffffff
+        last_timestamp = timestamp
+        values = ["%.3f" % (v / 1000.0) for v in fields[5:]]
+        print(",".join([str(number), "%.6f" % (time / 1e6), str(cycle),
+                        str(duration), str(flags & 1), str((flags >> 1) & 1),
+                        str(flags >> 2)] + values))
+        written += 1
+
+    print("records: %d, CRC errors: %d" % (written, errors), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
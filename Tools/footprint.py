@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+footprint.py
+
+   Author:
+    Email:
+
+RAM and flash footprint of the segway firmware per class, read from the map
+file of the TI linker (Debug/<project>.map, written by every CCS build).
+Each class is one object file (f.ex. GPIO.obj), so the module summary of the
+map file gives its code, constant data (flash) and initialized or zeroed data
+(RAM) directly. The section allocation lists the global objects
+(f.ex. main.obj (.bss:segway)), which contain the objects of all other
+classes, and the size of the initialization tables (.cinit) copied into the
+RAM at startup.
+Run it for two builds to compare them (f.ex. before and after a change):
+the difference is printed per class.
+
+Examples:
+  footprint.py Segway_Test/Debug/Segway_Test.map
+  footprint.py --compare old.map Segway_Test/Debug/Segway_Test.map
+"""
+
+import argparse
+import re
+
+
+MODULE = re.compile(r"^\s+(\S+\.obj)\s+(\d+)\s+(\d+)\s+(\d+)\s*$")
+ALLOCATION = re.compile(r"^\s+[0-9a-f]{8}\s+([0-9a-f]{8})\s+(\S+\.obj) "
+                        r"\((\.[\w.]+?)(?::(\S+))?\)\s*$")
+SECTION = re.compile(r"^(\.\S+)\s+\d+\s+[0-9a-f]{8}\s+([0-9a-f]{8})")
+
+
+def parse(path):
+    """Returns ({module: [code, ro data, rw data]}, {object: size},
+    {section: size}) of the map file."""
+    modules, objects, sections = {}, {}, {}
+    in_summary = False
+    with open(path, errors="replace") as stream:
+        for line in stream:
+            if line.startswith("MODULE SUMMARY"):
+                in_summary = True
+                continue
+            if in_summary:
+                if line.startswith(("LINKER GENERATED", "GLOBAL SYMBOLS")):
+                    in_summary = False
+                    continue
+                match = MODULE.match(line)
+                if match:
+                    name = match.group(1)[:-len(".obj")]
+                    modules[name] = [int(match.group(i)) for i in (2, 3, 4)]
+                continue
+            match = SECTION.match(line)
+            if match:
+                sections[match.group(1)] = int(match.group(2), 16)
+                continue
+            match = ALLOCATION.match(line)
+            if match and match.group(3) in (".bss", ".data") and match.group(4):
+                objects[match.group(4)] = int(match.group(1), 16)
+    return modules, objects, sections
+
+
+def table(title, columns, rows):
+    print(title)
+    print("\t".join(columns))
+    for row in rows:
+        print("\t".join(str(value) for value in row))
+    print()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1],
+                                     formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("map", help="map file of the TI linker")
+    parser.add_argument("--compare", metavar="MAP",
+                        help="older map file; print the differences")
+    args = parser.parse_args()
+
+    modules, objects, sections = parse(args.map)
+    if not modules:
+        raise SystemExit("no module summary in %s" % args.map)
+    old_modules, old_objects, old_sections = ({}, {}, {})
+    if args.compare:
+        old_modules, old_objects, old_sections = parse(args.compare)
+
+    rows = []
+    for name in sorted(modules):
+        code, ro_data, rw_data = modules[name]
+        row = [name, code + ro_data, rw_data]
+        if args.compare:
+            old = old_modules.get(name, [0, 0, 0])
+            row += [code + ro_data - old[0] - old[1], rw_data - old[2]]
+        rows.append(row)
+    columns = ["class", "flash", "ram"]
+    if args.compare:
+        columns += ["flash_diff", "ram_diff"]
+    table("Per class [bytes]", columns, rows)
+
+    rows = []
+    for name in sorted(objects, key=objects.get, reverse=True):
+        row = [name, objects[name]]
+        if args.compare:
+            row.append(objects[name] - old_objects.get(name, 0))
+        rows.append(row)
+    table("Global objects [bytes]", ["object", "ram"]
+          + (["diff"] if args.compare else []), rows)
+
+    # Copied or zeroed by the startup code (_c_int00).
+    rows = []
+    for name in (".cinit", ".data", ".bss", ".TI.ramfunc", ".vtable"):
+        if name in sections:
+            row = [name, sections[name]]
+            if args.compare:
+                row.append(sections[name] - old_sections.get(name, 0))
+            rows.append(row)
+    table("Sections [bytes]", ["section", "size"]
+          + (["diff"] if args.compare else []), rows)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+flashlog_check.py
+
+   Author:
+    Email:
+
+Checks the flash image written by flashlog_test with the reader
+Tools/flashlog_read.py: both runs are found, the first one lost its oldest
+sectors to the wrap-around but all remaining records are complete and
+contiguous up to the last one, the second one is complete, and seeking to a
+record starts exactly there.
+
+Example:
+  flashlog_check.py flashlog_test.bin
+"""
+
+import os
+import subprocess
+import sys
+
+TOOLS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+sys.path.insert(0, TOOLS)
+
+from flashlog_read import read_index, records, runs  # noqa: E402
+
+
+# Must match flashlog_test.cpp.
+FIRST_RUN_RECORDS = 5000
+SECOND_RUN_RECORDS = 300
+
+
+def fail(message):
+    raise SystemExit("FAIL: " + message)
+
+
+def expected(number):
+    """Fields of the record with the given number (see flashlog_test.cpp)."""
+    values = [((number * (i + 1)) % 30000) - 15000 for i in range(8)]
+    return (0x04, number & 0xffff, (number * 2500) & 0xffffffff,
+            1000 + number % 100, number & 0x1f) + tuple(values)
+
+
+def read_all(image, sectors, first=0):
+    generator = records(image, sectors, first)
+    result = []
+    while True:
+        try:
+            result.append(next(generator))
+        except StopIteration as stop:
+            return result, stop.value or 0
+
+
+def check_run(image, sectors, last):
+    result, errors = read_all(image, sectors)
+    if errors:
+        fail("%d CRC errors" % errors)
+    if not result:
+        fail("empty run")
+    numbers = [number for number, _ in result]
+    if numbers != list(range(numbers[0], last + 1)):
+        fail("records not contiguous up to %d" % last)
+    for number, fields in result:
+        if fields != expected(number):
+            fail("wrong content of record %d" % number)
+    return numbers[0]
+
+
+def check_seek(image, sectors, first):
+    result, _ = read_all(image, sectors, first)
+    if not result or result[0][0] != first or result[0][1] != expected(first):
+        fail("seeking to record %d failed" % first)
+
+
+def main():
+    if len(sys.argv) != 2:
+        raise SystemExit(__doc__)
+    with open(sys.argv[1], "rb") as stream:
+        image = stream.read()
+
+    all_runs = runs(read_index(image))
+    if sorted(all_runs) != [0, 1]:
+        fail("runs %s instead of [0, 1]" % sorted(all_runs))
+
+    oldest = check_run(image, all_runs[0], FIRST_RUN_RECORDS - 1)
+    if oldest == 0:
+        fail("the first run did not wrap around")
+    if check_run(image, all_runs[1], SECOND_RUN_RECORDS - 1) != 0:
+        fail("the second run is incomplete")
+
+    check_seek(image, all_runs[0], oldest + 1234)
+    check_seek(image, all_runs[1], 200)
+
+    # Command line of the reader: newest run as CSV.
+    output = subprocess.run([sys.executable,
+                             os.path.join(TOOLS, "flashlog_read.py"),
+                             "--image", sys.argv[1]],
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                            universal_newlines=True, check=True)
+    if len(output.stdout.splitlines()) != SECOND_RUN_RECORDS + 1:
+        fail("flashlog_read.py returned %d lines"
+             % len(output.stdout.splitlines()))
+
+    print("flashlog_check: run 0 records %d-%d, run 1 records 0-%d: OK"
+          % (oldest, FIRST_RUN_RECORDS - 1, SECOND_RUN_RECORDS - 1))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,120 @@
+/*
+ * flashlog_test.cpp
+ *
+ *    Author:
+ *     Email:
+ *
+ * Test of FlashLog (see FlashLog.h) with the emulated flash of the host
+ * build: a long first run wraps around the (small) flash several times, then
+ * a reboot starts a second run. The records are built like
+ * Segway::logRecord does, with values derived from the record number. The
+ * image of the flash is written to the given file and checked by
+ * flashlog_check.py with the reader Tools/flashlog_read.py.
+ *
+ * Usage: flashlog_test <image file>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "FlashLog.h"
+#include "TelemetryFrame.h"
+
+
+// Must match flashlog_check.py.
+static const uint32_t flashSize = 16 * FLASHLOG_SECTOR_SIZE;
+static const uint32_t firstRunRecords = 5000;
+static const uint32_t secondRunRecords = 300;
+static const uint32_t secondRunFlush = 150;
+
+
+static void check(bool condition, const char *message)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", message);
+        exit(1);
+    }
+}
+
+static void appendRecord(FlashLog &log, uint32_t number)
+{
+    /*
+     * Append the record with the given number (layout see
+     * Segway::logRecord) and program it like the background loop.
+     */
+
+    TelemetryFrame frame;
+    frame.begin(TELEMETRY_FRAME_RECORD);
+    frame.putU16(number);
+    frame.putU32(number * 2500);
+    frame.putU16(1000 + number % 100);
+    frame.putU8(number & 0x1f);
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        frame.putU16((int16_t) ((number * (i + 1)) % 30000 - 15000));
+    }
+    check(frame.finish(), "frame too long");
+    check(log.append(frame.getData(), frame.getLength()), "record dropped");
+
+    while (!log.isIdle())
+    {
+        log.process();
+    }
+}
+
+static void flush(FlashLog &log)
+{
+    log.flush();
+    while (!log.isIdle())
+    {
+        log.process();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    check(argc == 2, "usage: flashlog_test <image file>");
+
+    System sys;
+
+    // First boot with an erased flash.
+    FlashLog first;
+    first.init(&sys, SSI0_BASE, GPIO_PORTA_BASE, GPIO_PIN_3, 10000000, flashSize);
+    check(first.getRun() == 0, "first run is not 0");
+    for (uint32_t number = 0; number < firstRunRecords; number++)
+    {
+        appendRecord(first, number);
+    }
+    flush(first);
+    check(first.getRecords() == firstRunRecords, "wrong record count");
+    check(first.getDropped() == 0, "records dropped");
+
+    // Reboot: the emulated flash keeps its content, the log continues after
+    // the newest sector.
+    FlashLog second;
+    second.init(&sys, SSI0_BASE, GPIO_PORTA_BASE, GPIO_PIN_3, 10000000, flashSize);
+    check(second.getRun() == 1, "second run is not 1");
+    for (uint32_t number = 0; number < secondRunRecords; number++)
+    {
+        appendRecord(second, number);
+
+        // End of a ride: partially filled page.
+        if (number == secondRunFlush)
+        {
+            flush(second);
+        }
+    }
+    flush(second);
+    check(second.getDropped() == 0, "records dropped");
+
+    static uint8_t image[flashSize];
+    second.read(0, image, flashSize);
+    FILE *file = fopen(argv[1], "wb");
+    check(file && (fwrite(image, 1, flashSize, file) == flashSize),
+          "cannot write the image");
+    fclose(file);
+
+    printf("flashlog_test: %u + %u records written to %s\n", firstRunRecords,
+           secondRunRecords, argv[1]);
+    return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * host_stubs.cpp
+ *
+ *    Author:
+ *     Email:
+ *
+ * Stand-ins for the parts of System and GPIO the host tests link against.
+ * The real classes access the hardware, which does not exist on the host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "System.h"
+#include "GPIO.h"
+
+
+System::System()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+System::~System()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+void System::error(ErrorCodes errorCode, void *faultOrigin0,
+                   void *faultOrigin1, void *faultOrigin2)
+{
+    /*
+     * Any error fails the test.
+     */
+
+    printf("FAIL: System::error(%d, %p, %p, %p)\n", (int) errorCode,
+           faultOrigin0, faultOrigin1, faultOrigin2);
+    exit(1);
+}
+
+GPIO::GPIO()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+GPIO::~GPIO()
+{
+    /*
+     * Default empty destructor
+     */
+}
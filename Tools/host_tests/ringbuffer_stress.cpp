@@ -0,0 +1,142 @@
+/*
+ * ringbuffer_stress.cpp
+ *
+ *    Author:
+ *     Email:
+ *
+ * Stress test of RingBuffer (see RingBuffer.h) on the host: a producer and a
+ * consumer thread, like the control ISR and the background loop, pass
+ * numbered items through a small buffer as fast as they can. The consumer
+ * pauses now and then, so the buffer runs full and items are dropped.
+ * Checked:
+ * - Every item arrives complete (no torn copies) and in order.
+ * - The missing item numbers are exactly the ones the producer could not
+ *   push, and their count matches RingBuffer::getDropped.
+ * - Nothing is lost except the dropped items.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "RingBuffer.h"
+
+
+struct Item
+{
+    uint32_t number;
+    uint32_t inverted;      // ~number
+    uint32_t payload[6];    // number * (i + 1)
+};
+
+static const uint32_t itemCount = 1u << 22;
+
+static RingBuffer<Item, 64> buffer;
+
+// Written by the producer, read by the consumer after joining.
+static std::vector<uint8_t> droppedItems(itemCount, 0);
+static std::atomic<bool> producerDone(false);
+
+
+static void check(bool condition, const char *message, uint32_t number)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s (item %u)\n", message, number);
+        exit(1);
+    }
+}
+
+static void produce()
+{
+    for (uint32_t number = 0; number < itemCount; number++)
+    {
+        Item item;
+        item.number = number;
+        item.inverted = ~number;
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            item.payload[i] = number * (i + 1);
+        }
+        if (!buffer.push(item))
+        {
+            droppedItems[number] = 1;
+        }
+
+        // A few cycles between the items, like the period of the ISR. The
+        // yield lets the consumer run on a single core host, too.
+        for (volatile uint32_t i = 0; i < 20; i++);
+        if ((number % 32) == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    producerDone = true;
+}
+
+int main()
+{
+    std::thread producer(produce);
+
+    std::vector<uint32_t> received;
+    received.reserve(itemCount);
+    uint32_t pops = 0;
+    Item item;
+    while (true)
+    {
+        if (buffer.pop(item))
+        {
+            check(item.inverted == ~item.number, "torn item", item.number);
+            for (uint32_t i = 0; i < 6; i++)
+            {
+                check(item.payload[i] == item.number * (i + 1), "torn item",
+                      item.number);
+            }
+            check(received.empty() || (item.number > received.back()),
+                  "item out of order", item.number);
+            received.push_back(item.number);
+
+            // Let the buffer run full from time to time, like a slow
+            // background loop.
+            if ((++pops % 65536) == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+        else if (producerDone && !buffer.available())
+        {
+            // The producer wrote its last index before setting the flag.
+            break;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    uint32_t dropped = 0;
+    uint32_t next = 0;
+    for (uint32_t number = 0; number < itemCount; number++)
+    {
+        if (droppedItems[number])
+        {
+            dropped++;
+            continue;
+        }
+        check(next < received.size(), "item lost", number);
+        check(received[next] == number, "item lost", number);
+        next++;
+    }
+    check(next == received.size(), "unexpected item", received.back());
+    check(dropped == buffer.getDropped(), "wrong drop counter", dropped);
+    check(dropped > 0, "buffer never ran full", 0);
+    check(received.size() > itemCount / 2, "too few items exchanged",
+          received.size());
+
+    printf("ringbuffer_stress: %u items, %u received, %u dropped: OK\n",
+           itemCount, (uint32_t) received.size(), dropped);
+    return 0;
+}
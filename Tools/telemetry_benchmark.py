@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""
+telemetry_benchmark.py
+
+   Author:
+    Email:
+
+Compression benchmark for the telemetry of the segway. It reads a recorded run
+and encodes it again like the firmware (System::sendDebugBinary) does: as text
+lines, as binary data frames and compressed (DebugCompressed) with different
+keyframe periods. For each variant the average frame length, the ratio to the
+text format and the maximum frame rate at the given baud rate are printed.
+
+The run can be a binary recording (telemetry_decode.py --raw) or a CSV file
+written by telemetry_decode.py. CSV columns containing only integers are
+treated as int32 (or int16 if all values fit), others as float.
+
+Example:
+  telemetry_benchmark.py --file run.bin --baud 115200
+"""
+
+import argparse
+import csv
+import struct
+
+from telemetry_decode import Decoder, frames, crc16, TYPES
+
+
+def cobs_encode(data):
+    """COBS encode a frame and append the delimiter (TelemetryFrame::finish)."""
+    out = bytearray([0])
+    code_index = 0
+    code = 1
+    for byte in data:
+        if byte == 0:
+            out[code_index] = code
+            code_index = len(out)
+            out.append(0)
+            code = 1
+        else:
+            out.append(byte)
+            code += 1
+            if code == 0xff:
+                out[code_index] = code
+                code_index = len(out)
+                out.append(0)
+                code = 1
+    out[code_index] = code
+    out.append(0)
+    return bytes(out)
+
+
+def varint(value):
+    """TelemetryFrame::putVarint"""
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7f) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def zigzag(value):
+    """TelemetryFrame::zigzag for a 32 bit value given as unsigned int."""
+    signed = value - (1 << 32) if value & 0x80000000 else value
+    return ((signed << 1) ^ (signed >> 31)) & 0xffffffff
+
+
+def finish(frame):
+    return cobs_encode(frame + struct.pack("<H", crc16(frame)))
+
+
+def encode_run(types, rows, key_period):
+    """
+    Encode all rows as data frames (key_period 1) or compressed. Returns the
+    total number of bytes on the link, channel frames excluded.
+    """
+    total = 0
+    previous = None
+    previous_time = 0
+    since_key = key_period
+    for counter, (timestamp, values) in enumerate(rows):
+        counter &= 0xffff
+        if since_key >= key_period:
+            since_key = 0
+            frame = struct.pack("<BHI", 0x01, counter, timestamp)
+        else:
+            frame = (struct.pack("<BH", 0x03, counter)
+                     + varint((timestamp - previous_time) & 0xffffffff))
+        frame += bytes([0, 0])      # layout, flags
+        for i, value in enumerate(values):
+            if since_key == 0:
+                frame += struct.pack("<H" if TYPES[types[i]] == 2 else "<I",
+                                     value & (0xffff if TYPES[types[i]] == 2
+                                              else 0xffffffff))
+            else:
+                frame += varint(zigzag((value - previous[i]) & 0xffffffff))
+        since_key += 1
+        previous = values
+        previous_time = timestamp
+        total += len(finish(frame))
+    return total
+
+
+def text_length(types, rows):
+    """Length of the text format (System::sendDebugText) without labels."""
+    total = 0
+    for _, values in rows:
+        for i, value in enumerate(values):
+            if types[i] == 2:
+                value = int(struct.unpack("<f", struct.pack("<I", value))[0])
+            elif value & 0x80000000:
+                value -= 1 << 32
+            total += len("%04d\t" % value)
+        total += 2      # uartstdio sends "\r\n"
+    return total
+
+
+def load_binary(path):
+    """Rows of raw 32 bit values from a binary recording."""
+    decoder = Decoder()
+    rows = []
+    types = None
+    with open(path, "rb") as stream:
+        for encoded in frames(stream):
+            row = decoder.frame(encoded)
+            if row is None:
+                continue
+            row_types = [decoder.channels[i][0] for i in range(decoder.count)]
+            if types is None:
+                types = row_types
+            elif row_types != types:
+                # Only the first channel layout is benchmarked.
+                break
+            rows.append((int(row[0] * 1e6), list(decoder.reference)))
+    return types, rows
+
+
+def load_csv(path):
+    """Rows of raw 32 bit values from a CSV file of telemetry_decode.py."""
+    with open(path, newline="") as stream:
+        table = list(csv.reader(stream))
+    header, table = table[0], table[1:]
+    columns = list(zip(*table))[1:]
+    types = []
+    for column in columns:
+        try:
+            numbers = [int(v) for v in column]
+            small = all(-0x8000 <= v < 0x8000 for v in numbers)
+            types.append(0 if small else 1)
+        except ValueError:
+            types.append(2)
+    rows = []
+    for line in table:
+        values = []
+        for value, ctype in zip(line[1:], types):
+            if ctype == 2:
+                values.append(struct.unpack("<I", struct.pack("<f", float(value)))[0])
+            else:
+                values.append(int(value) & 0xffffffff)
+        rows.append((int(float(line[0]) * 1e6) & 0xffffffff, values))
+    return types, rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("--file", required=True, help="binary recording or CSV file")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    if args.file.lower().endswith(".csv"):
+        types, rows = load_csv(args.file)
+    else:
+        types, rows = load_binary(args.file)
+    if not rows:
+        raise SystemExit("no complete data frames found")
+
+    # 8N1: 10 bits per byte on the link
+    bytes_per_second = args.baud / 10.0
+    variants = [("text", text_length(types, rows)),
+                ("binary", encode_run(types, rows, 1))]
+    for period in (4, 8, 16, 32, 64):
+        variants.append(("compressed, keyframe every %d" % period,
+                         encode_run(types, rows, period)))
+
+    text = variants[0][1]
+    print("%d frames, %d channels, %d baud" % (len(rows), len(types), args.baud))
+    print("%-32s %10s %8s %10s" % ("format", "bytes/frame", "ratio", "max. Hz"))
+    for name, total in variants:
+        per_frame = total / float(len(rows))
+        print("%-32s %10.1f %8.2f %10.0f"
+              % (name, per_frame, text / float(total), bytes_per_second / per_frame))
+
+
+if __name__ == "__main__":
+    main()
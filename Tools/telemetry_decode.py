@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""
+telemetry_decode.py
+
+   Author:
+    Email:
+
+Decoder for the binary telemetry of the segway (System::setDebugFormat with
+DebugBinary, see System::sendDebugBinary and TelemetryFrame.h for the frame
+layout). It reads the stream from a serial port or a recorded file and writes
+either CSV or the text format of the Arduino serial plotter to stdout.
+Frames with a wrong CRC and lost frames (gaps in the frame counter) are
+counted and reported on stderr at the end. Compressed streams (DebugCompressed)
+are decoded, too; after a lost frame the delta frames are skipped until the
+next keyframe.
+
+Examples:
+  telemetry_decode.py --port /dev/ttyACM0 --format csv > run.csv
+  telemetry_decode.py --port COM3 --raw run.bin --format plotter
+  telemetry_decode.py --file run.bin --format csv > run.csv
+
+Reading from a serial port requires pyserial (pip install pyserial).
+"""
+
+import argparse
+import struct
+import sys
+
+
+FRAME_DATA = 0x01
+FRAME_CHANNEL = 0x02
+FRAME_DELTA = 0x03
+
+# DebugType (System.h): size of a value inside a data frame
+TYPES = {0: 2,      # DebugInt16
+         1: 4,      # DebugInt32
+         2: 4}      # DebugFloat
+
+
+def cobs_decode(data):
+    """Decode a COBS encoded frame (without the zero delimiter)."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            raise ValueError("invalid COBS code")
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xff and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def read_varint(data, offset):
+    """Read a varint (TelemetryFrame::putVarint). Returns (value, offset)."""
+    value = 0
+    shift = 0
+    while True:
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7f) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value & 0xffffffff, offset
+
+
+def unzigzag(value):
+    """Inverse of TelemetryFrame::zigzag, as unsigned 32 bit value."""
+    return ((value >> 1) ^ -(value & 1)) & 0xffffffff
+
+
+def to_value(raw, ctype):
+    """Convert the raw 32 bits of a channel to int or float."""
+    if ctype == 2:
+        return struct.unpack("<f", struct.pack("<I", raw))[0]
+    return raw - (1 << 32) if raw & 0x80000000 else raw
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, same as TelemetryFrame::crc."""
+    crc = 0xffff
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            if crc & 0x8000:
+                crc = ((crc << 1) ^ 0x1021) & 0xffff
+            else:
+                crc = (crc << 1) & 0xffff
+    return crc
+
+
+class Decoder:
+    """Turns frames into rows of (timestamp in s, [values]) ."""
+
+    def __init__(self):
+        self.layout = None          # layout id of the known channels
+        self.channels = {}          # position -> (type, name)
+        self.count = 0
+        self.last_counter = None
+        self.crc_errors = 0
+        self.lost_frames = 0
+        self.unknown_layout = 0
+        self.frames = 0
+        self.too_many = False
+        self.reference = None       # raw values of the last frame
+        self.timestamp = 0          # timestamp of the last frame in us
+        self.bytes = 0              # received bytes incl. delimiters
+        self.data_bytes = 0         # bytes of data and delta frames
+
+    def complete(self):
+        return len(self.channels) == self.count
+
+    def names(self):
+        return [self.channels[i][1] for i in range(self.count)]
+
+    def frame(self, encoded):
+        """Process one encoded frame. Returns a row or None."""
+        self.bytes += len(encoded) + 1
+        try:
+            raw = cobs_decode(encoded)
+        except ValueError:
+            self.crc_errors += 1
+            return None
+        if len(raw) < 3 or crc16(raw[:-2]) != struct.unpack("<H", raw[-2:])[0]:
+            self.crc_errors += 1
+            return None
+        raw = raw[:-2]
+        self.frames += 1
+
+        frame_type = raw[0]
+        counter = struct.unpack_from("<H", raw, 1)[0]
+        if self.last_counter is not None:
+            lost = (counter - self.last_counter - 1) & 0xffff
+            if lost:
+                self.lost_frames += lost
+                self.reference = None
+        self.last_counter = counter
+
+        if frame_type == FRAME_CHANNEL:
+            layout, position, count, ctype = raw[3:7]
+            if layout != self.layout:
+                self.layout = layout
+                self.channels = {}
+            self.count = count
+            self.channels[position] = (ctype, raw[7:].decode("ascii", "replace"))
+            return None
+
+        if frame_type in (FRAME_DATA, FRAME_DELTA):
+            self.data_bytes += len(encoded) + 1
+            if frame_type == FRAME_DATA:
+                self.timestamp = struct.unpack_from("<I", raw, 3)[0]
+                offset = 7
+            else:
+                delta, offset = read_varint(raw, 3)
+                self.timestamp = (self.timestamp + delta) & 0xffffffff
+            layout, flags = raw[offset:offset + 2]
+            offset += 2
+            self.too_many = bool(flags & 1)
+            if layout != self.layout or not self.complete():
+                self.unknown_layout += 1
+                return None
+            if frame_type == FRAME_DELTA and self.reference is None:
+                # Wait for the next keyframe.
+                return None
+
+            values = []
+            for i in range(self.count):
+                ctype = self.channels[i][0]
+                if frame_type == FRAME_DATA:
+                    if TYPES[ctype] == 2:
+                        raw_value = struct.unpack_from("<H", raw, offset)[0]
+                        if raw_value & 0x8000:
+                            raw_value |= 0xffff0000
+                    else:
+                        raw_value = struct.unpack_from("<I", raw, offset)[0]
+                    offset += TYPES[ctype]
+                else:
+                    delta, offset = read_varint(raw, offset)
+                    raw_value = (self.reference[i] + unzigzag(delta)) & 0xffffffff
+                values.append(raw_value)
+            self.reference = values
+            return (self.timestamp / 1e6,
+                    [to_value(v, self.channels[i][0]) for i, v in enumerate(values)])
+
+        return None
+
+
+def frames(stream, raw_copy=None):
+    """Split a byte stream into encoded frames at the zero delimiters."""
+    buffer = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            return
+        if raw_copy:
+            raw_copy.write(chunk)
+        buffer += chunk
+        while True:
+            end = buffer.find(0)
+            if end < 0:
+                break
+            if end > 0:
+                yield bytes(buffer[:end])
+            del buffer[:end + 1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1],
+                                     formatter_class=argparse.RawTextHelpFormatter)
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial port of the segway")
+    source.add_argument("--file", help="recorded binary stream ('-' for stdin)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--raw", help="additionally record the binary stream to this file")
+    parser.add_argument("--format", choices=["csv", "plotter"], default="csv")
+    args = parser.parse_args()
+
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud, timeout=1)
+    elif args.file == "-":
+        stream = sys.stdin.buffer
+    else:
+        stream = open(args.file, "rb")
+    raw_copy = open(args.raw, "wb") if args.raw else None
+
+    decoder = Decoder()
+    header = None
+    separator = "," if args.format == "csv" else "\t"
+    try:
+        for encoded in frames(stream, raw_copy):
+            row = decoder.frame(encoded)
+            if row is None:
+                continue
+            names = decoder.names()
+            if names != header:
+                # The plotter expects the labels whenever they change.
+                header = names
+                if args.format == "csv":
+                    print(separator.join(["Time_[s]"] + names))
+                else:
+                    print(separator.join(names))
+            timestamp, values = row
+            values = [str(v) if isinstance(v, int) else "%.7g" % v
+                      for v in values]
+            if args.format == "csv":
+                values = ["%.6f" % timestamp] + values
+            print(separator.join(values), flush=args.port is not None)
+    except KeyboardInterrupt:
+        pass
+
+    print("frames: %d, bytes: %d, lost: %d, CRC errors: %d, unknown layout: %d%s"
+          % (decoder.frames, decoder.bytes, decoder.lost_frames,
+             decoder.crc_errors, decoder.unknown_layout,
+             ", too many debug values" if decoder.too_many else ""),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()